@@ -0,0 +1,125 @@
+#include "asset_loader.h"
+#include "obj_loader.h"
+#include "mesh_optimize.h"
+#include "mesh_simplify.h"
+#include "meshlet.h"
+
+#include <algorithm>
+#include <sstream>
+
+// All parts come from the cache or none do
+static bool openCachedParts(const char* path, const Options& options, LoadedMesh& loaded) {
+    for (unsigned int part = 0, count = 1; part < count; part++) {
+        loaded.parts.emplace_back(new LoadedPart());
+        LoadedPart& loadedPart = *loaded.parts.back();
+        if (!loadedPart.cache.open(path, part, options.layout, options.optimize) ||
+            (part > 0 && loadedPart.cache.partCount() != count)) {
+            loaded.parts.clear();
+            return false;
+        }
+        count = loadedPart.cache.partCount();
+        loadedPart.view = loadedPart.cache.view();
+        loadedPart.material = loadedPart.cache.material();
+    }
+    return true;
+}
+
+void loadMeshData(const char* path, const Options& options, LoadedMesh& loaded, std::string& report,
+                  unsigned int parseThreads) {
+    loaded.path = path;
+    loaded.parts.clear();
+    loaded.scratchBytes = 0;
+    if (options.useCache && openCachedParts(path, options, loaded)) {
+        return;
+    }
+
+    std::ostringstream out;
+    std::vector<Mesh> meshes;
+    Mesh source = loadOBJ(path, 0, &loaded.scratchBytes, parseThreads);
+    if (source.submeshes.size() > 1) {
+        for (const Submesh& submesh : source.submeshes) {
+            meshes.push_back(extractSubmesh(source, submesh));
+        }
+        out << path << " split into " << meshes.size() << " parts by material\n";
+    }
+    else {
+        meshes.push_back(std::move(source));
+    }
+
+    unsigned int partCount = static_cast<unsigned int>(meshes.size());
+    for (unsigned int part = 0; part < partCount; part++) {
+        loaded.parts.emplace_back(new LoadedPart());
+        LoadedPart& loadedPart = *loaded.parts.back();
+        Mesh& mesh = loadedPart.mesh;
+        mesh = std::move(meshes[part]);
+        if (!mesh.submeshes.empty() && mesh.submeshes[0].material >= 0) {
+            loadedPart.material = &mesh.materials[mesh.submeshes[0].material];
+        }
+        std::string name = partCount > 1 ? std::string(path) + " [" + (loadedPart.material ? loadedPart.material->name : "no material") + "]" : path;
+
+        if (options.optimize) {
+            MeshOptimizeReport stats = optimizeMesh(mesh);
+            out << name << " vertex cache: ACMR " << stats.before.acmr << " -> " << stats.after.acmr
+                << ", ATVR " << stats.before.atvr << " -> " << stats.after.atvr << "\n";
+        }
+        buildLodChain(mesh);
+        mesh.meshlets = buildMeshlets(mesh);
+        out << name << " LODs:";
+        for (const MeshLod& lod : mesh.lods) {
+            out << " " << lod.indexCount / 3 << " (error " << lod.error << ")";
+        }
+        out << ", " << mesh.meshlets.size() << " meshlets\n";
+        loadedPart.packed = packVertices(mesh, options.layout);
+        loadedPart.view = makeMeshView(mesh, loadedPart.packed);
+        if (options.useCache && !writeMeshCache(path, part, partCount, loadedPart.view, options.optimize, loadedPart.material,
+                                                mesh.materialLibraries)) {
+            out << "Could not write mesh cache for " << name << "\n";
+        }
+        // The view has the count; the packed copy is what gets uploaded
+        std::vector<Vertex>().swap(mesh.vertices);
+    }
+    report += out.str();
+}
+
+void AssetLoader::start(const std::vector<std::string>& paths, const Options& options) {
+    // Each parse already splits large files across cores, so one worker per
+    // mesh is enough for small scenes. The cores are shared out between the
+    // workers, so several large files never start more parse threads than
+    // there are cores. Chunks cannot run on this pool: a worker waiting for
+    // its own chunks would hold a thread the chunks need.
+    unsigned int threads = std::max(std::thread::hardware_concurrency(), 1u);
+    unsigned int workers = static_cast<unsigned int>(std::max<size_t>(std::min<size_t>(threads, paths.size()), 1));
+    unsigned int parseThreads = std::max(threads / workers, 1u);
+    pool.reset(new ThreadPool(workers));
+    meshes.clear();
+    finished = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        meshes.emplace_back(new LoadedMesh());
+    }
+    for (size_t i = 0; i < paths.size(); i++) {
+        LoadedMesh* loaded = meshes[i].get();
+        std::string path = paths[i];
+        pool->submit([this, loaded, path, options, parseThreads] {
+            std::string lines;
+            loadMeshData(path.c_str(), options, *loaded, lines, parseThreads);
+            {
+                std::lock_guard<std::mutex> lock(reportMutex);
+                report += lines;
+            }
+            finished++;
+        });
+    }
+}
+
+std::string AssetLoader::takeReport() {
+    std::lock_guard<std::mutex> lock(reportMutex);
+    std::string lines;
+    lines.swap(report);
+    return lines;
+}
+
+void AssetLoader::clear() {
+    pool.reset();
+    meshes.clear();
+    finished = 0;
+}
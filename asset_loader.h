@@ -0,0 +1,72 @@
+#pragma once
+
+#include "gpu_mesh.h"
+#include "mesh_cache.h"
+#include "options.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Everything the render thread needs to upload one mesh. `view` points either
+// into the open cache or into `mesh` and `packed`, so the object must stay put
+// until the upload has finished. Once packed, `mesh` keeps only what the upload
+// reads (indices, levels, meshlets and the material); its float vertices are freed.
+struct LoadedPart {
+    MeshCache cache;
+    Mesh mesh;
+    PackedVertices packed;
+    MeshView view;
+    // Null when the faces had no usemtl; points into `cache` or `mesh`
+    const Material* material = nullptr;
+};
+
+// One OBJ file: a single part, or one per material when it uses several, so
+// each draw binds one material
+struct LoadedMesh {
+    std::string path;
+    std::vector<std::unique_ptr<LoadedPart>> parts;
+    // Peak arena bytes of the OBJ parse; 0 when the parts came from the cache
+    size_t scratchBytes = 0;
+};
+
+// Fills `loaded` from the mesh cache when it is up to date, otherwise parses,
+// splits, optimizes and packs the OBJ and writes the cache. Progress lines are appended
+// to `report` rather than printed, so workers do not interleave their output.
+// A large OBJ is parsed on at most `parseThreads` threads (0: one per core).
+void loadMeshData(const char* path, const Options& options, LoadedMesh& loaded, std::string& report,
+                  unsigned int parseThreads = 0);
+
+// Loads every mesh of a scene on a worker pool while the render thread keeps
+// drawing. Results are handed out in request order once all have finished.
+class AssetLoader {
+public:
+    AssetLoader() = default;
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    void start(const std::vector<std::string>& paths, const Options& options);
+
+    size_t requested() const { return meshes.size(); }
+    size_t completed() const { return finished.load(); }
+    bool done() const { return completed() == requested(); }
+    void wait() { if (pool) pool->wait(); }
+
+    // Progress lines produced since the last call
+    std::string takeReport();
+
+    // Only valid once done()
+    LoadedMesh& mesh(size_t index) { return *meshes[index]; }
+    // Drops the CPU copies once everything is on the GPU
+    void clear();
+
+private:
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<std::unique_ptr<LoadedMesh>> meshes;
+    std::atomic<size_t> finished{ 0 };
+    std::mutex reportMutex;
+    std::string report;
+};
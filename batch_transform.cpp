@@ -0,0 +1,315 @@
+#include "batch_transform.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// One SIMD backend is picked at compile time from the target flags; building
+// with AVX2 and FMA enabled (/arch:AVX2, -mavx2 -mfma) selects the 8-wide path
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BATCH_TRANSFORM_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BATCH_TRANSFORM_SSE2 1
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define BATCH_TRANSFORM_NEON 1
+#endif
+
+glm::mat4 placementMatrix(const ObjectPlacement& placement) {
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), placement.position);
+    model = glm::rotate(model, placement.angleY, glm::vec3(0.0f, 1.0f, 0.0f));
+    model = glm::rotate(model, placement.angleZ, glm::vec3(0.0f, 0.0f, 1.0f));
+    return glm::scale(model, glm::vec3(placement.scale));
+}
+
+void TransformInputs::add(const ObjectPlacement& placement, const Bounds& bounds) {
+    positionX.push_back(placement.position.x);
+    positionY.push_back(placement.position.y);
+    positionZ.push_back(placement.position.z);
+    angleY.push_back(placement.angleY);
+    angleZ.push_back(placement.angleZ);
+    scale.push_back(placement.scale);
+    sphereX.push_back(bounds.center.x);
+    sphereY.push_back(bounds.center.y);
+    sphereZ.push_back(bounds.center.z);
+    sphereRadius.push_back(bounds.radius);
+}
+
+void TransformOutputs::resize(size_t count) {
+    world.resize(count);
+    mvp.resize(count);
+    sphereX.resize(count);
+    sphereY.resize(count);
+    sphereZ.resize(count);
+    sphereRadius.resize(count);
+}
+
+// Each backend exposes the same handful of operations on V (one float per
+// object) and M (a per-object mask), so the kernel below is written once.
+// storeColumn writes lane i of (r0, r1, r2, r3) as the vec4 at first + i * stride.
+struct ScalarLanes {
+    typedef float V;
+    typedef bool M;
+    static const size_t kWidth = 1;
+
+    static V load(const float* p) { return *p; }
+    static void store(float* p, V v) { *p = v; }
+    static V set(float x) { return x; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static V mulAdd(V a, V b, V c) { return a * b + c; }
+    static V sqrt(V a) { return std::sqrt(a); }
+    static M bitSet(V a, uint32_t bit) {
+        uint32_t bits;
+        std::memcpy(&bits, &a, sizeof(bits));
+        return (bits & bit) != 0;
+    }
+    static V select(M m, V a, V b) { return m ? a : b; }
+    static V negateIf(M m, V a) { return m ? -a : a; }
+    static void storeColumn(V r0, V r1, V r2, V r3, float* first, size_t) {
+        first[0] = r0;
+        first[1] = r1;
+        first[2] = r2;
+        first[3] = r3;
+    }
+};
+
+#if BATCH_TRANSFORM_AVX2
+struct SimdLanes {
+    typedef __m256 V;
+    typedef __m256 M;
+    static const size_t kWidth = 8;
+
+    static V load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+    static V set(float x) { return _mm256_set1_ps(x); }
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+#if defined(__FMA__) || defined(_MSC_VER)
+    static V mulAdd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+    static V mulAdd(V a, V b, V c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+    static V sqrt(V a) { return _mm256_sqrt_ps(a); }
+    static M bitSet(V a, uint32_t bit) {
+        __m256i mask = _mm256_set1_epi32(static_cast<int>(bit));
+        return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_castps_si256(a), mask), mask));
+    }
+    static V select(M m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+    static V negateIf(M m, V a) { return _mm256_xor_ps(a, _mm256_and_ps(m, _mm256_set1_ps(-0.0f))); }
+    static void storeColumn(V r0, V r1, V r2, V r3, float* first, size_t stride) {
+        // Two 4x4 transposes, one per 128-bit half
+        for (int half = 0; half < 2; half++) {
+            __m128 a = half ? _mm256_extractf128_ps(r0, 1) : _mm256_castps256_ps128(r0);
+            __m128 b = half ? _mm256_extractf128_ps(r1, 1) : _mm256_castps256_ps128(r1);
+            __m128 c = half ? _mm256_extractf128_ps(r2, 1) : _mm256_castps256_ps128(r2);
+            __m128 d = half ? _mm256_extractf128_ps(r3, 1) : _mm256_castps256_ps128(r3);
+            _MM_TRANSPOSE4_PS(a, b, c, d);
+            float* out = first + half * 4 * stride;
+            _mm_storeu_ps(out, a);
+            _mm_storeu_ps(out + stride, b);
+            _mm_storeu_ps(out + 2 * stride, c);
+            _mm_storeu_ps(out + 3 * stride, d);
+        }
+    }
+};
+#elif BATCH_TRANSFORM_SSE2
+struct SimdLanes {
+    typedef __m128 V;
+    typedef __m128 M;
+    static const size_t kWidth = 4;
+
+    static V load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, V v) { _mm_storeu_ps(p, v); }
+    static V set(float x) { return _mm_set1_ps(x); }
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V mulAdd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static V sqrt(V a) { return _mm_sqrt_ps(a); }
+    static M bitSet(V a, uint32_t bit) {
+        __m128i mask = _mm_set1_epi32(static_cast<int>(bit));
+        return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_castps_si128(a), mask), mask));
+    }
+    static V select(M m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    static V negateIf(M m, V a) { return _mm_xor_ps(a, _mm_and_ps(m, _mm_set1_ps(-0.0f))); }
+    static void storeColumn(V r0, V r1, V r2, V r3, float* first, size_t stride) {
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(first, r0);
+        _mm_storeu_ps(first + stride, r1);
+        _mm_storeu_ps(first + 2 * stride, r2);
+        _mm_storeu_ps(first + 3 * stride, r3);
+    }
+};
+#elif BATCH_TRANSFORM_NEON
+struct SimdLanes {
+    typedef float32x4_t V;
+    typedef uint32x4_t M;
+    static const size_t kWidth = 4;
+
+    static V load(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, V v) { vst1q_f32(p, v); }
+    static V set(float x) { return vdupq_n_f32(x); }
+    static V add(V a, V b) { return vaddq_f32(a, b); }
+    static V sub(V a, V b) { return vsubq_f32(a, b); }
+    static V mul(V a, V b) { return vmulq_f32(a, b); }
+    static V mulAdd(V a, V b, V c) { return vfmaq_f32(c, a, b); }
+    static V sqrt(V a) { return vsqrtq_f32(a); }
+    static M bitSet(V a, uint32_t bit) { return vtstq_u32(vreinterpretq_u32_f32(a), vdupq_n_u32(bit)); }
+    static V select(M m, V a, V b) { return vbslq_f32(m, a, b); }
+    static V negateIf(M m, V a) {
+        return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), vandq_u32(m, vdupq_n_u32(0x80000000u))));
+    }
+    static void storeColumn(V r0, V r1, V r2, V r3, float* first, size_t stride) {
+        float32x4x2_t ab = vtrnq_f32(r0, r1);
+        float32x4x2_t cd = vtrnq_f32(r2, r3);
+        vst1q_f32(first, vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0])));
+        vst1q_f32(first + stride, vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1])));
+        vst1q_f32(first + 2 * stride, vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0])));
+        vst1q_f32(first + 3 * stride, vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1])));
+    }
+};
+#endif
+
+// Cephes-style sinf/cosf: reduce to [-pi/4, pi/4] around the nearest multiple
+// of pi/2, evaluate both polynomials, then swap and negate by quadrant. Within
+// a few ulp of std::sin/std::cos for angles up to a few thousand radians.
+template <class L>
+static void sinCos(typename L::V x, typename L::V& sine, typename L::V& cosine) {
+    typedef typename L::V V;
+    typedef typename L::M M;
+    // Adding 1.5 * 2^23 rounds to the nearest integer and leaves it in the low
+    // mantissa bits, where the quadrant tests read it
+    const float kRoundMagic = 12582912.0f;
+    V shifted = L::mulAdd(x, L::set(0.636619772f), L::set(kRoundMagic));
+    V quadrant = L::sub(shifted, L::set(kRoundMagic));
+    // x - quadrant * pi/2, with pi/2 split in three so the reduction stays exact
+    V r = L::mulAdd(quadrant, L::set(-1.5703125f), x);
+    r = L::mulAdd(quadrant, L::set(-4.837512969970703125e-4f), r);
+    r = L::mulAdd(quadrant, L::set(-7.54978995489188216e-8f), r);
+    V r2 = L::mul(r, r);
+
+    V s = L::mulAdd(r2, L::set(-1.9515295891e-4f), L::set(8.3321608736e-3f));
+    s = L::mulAdd(s, r2, L::set(-1.6666654611e-1f));
+    s = L::mulAdd(L::mul(s, r2), r, r);
+    V c = L::mulAdd(r2, L::set(2.443315711809948e-5f), L::set(-1.388731625493765e-3f));
+    c = L::mulAdd(c, r2, L::set(4.166664568298827e-2f));
+    c = L::mulAdd(L::mul(c, r2), r2, L::mulAdd(r2, L::set(-0.5f), L::set(1.0f)));
+
+    // Quadrants 1 and 3 swap the two; sine is negative in 2 and 3, cosine in 1 and 2
+    M swap = L::bitSet(shifted, 1);
+    M negateSine = L::bitSet(shifted, 2);
+    M negateCosine = L::bitSet(L::add(shifted, L::set(1.0f)), 2);
+    sine = L::negateIf(negateSine, L::select(swap, c, s));
+    cosine = L::negateIf(negateCosine, L::select(swap, s, c));
+}
+
+// Objects [i, i + L::kWidth). Column j of world is placement * parent[j]; the
+// placement's bottom row is (0, 0, 0, 1), so world's bottom row is parent's.
+template <class L>
+static void transformLanes(const TransformInputs& in, const glm::mat4& parent, const glm::mat4& viewProjection,
+                           TransformOutputs& out, size_t i) {
+    typedef typename L::V V;
+    V sinY, cosY, sinZ, cosZ;
+    sinCos<L>(L::load(&in.angleY[i]), sinY, cosY);
+    sinCos<L>(L::load(&in.angleZ[i]), sinZ, cosZ);
+    V scale = L::load(&in.scale[i]);
+    V zero = L::set(0.0f);
+
+    // Columns of scale * rotateY * rotateZ, then the translation
+    V sinYScale = L::mul(sinY, scale), cosYScale = L::mul(cosY, scale);
+    V placement[4][3] = {
+        { L::mul(cosYScale, cosZ), L::mul(sinZ, scale), L::sub(zero, L::mul(sinYScale, cosZ)) },
+        { L::sub(zero, L::mul(cosYScale, sinZ)), L::mul(cosZ, scale), L::mul(sinYScale, sinZ) },
+        { sinYScale, zero, cosYScale },
+        { L::load(&in.positionX[i]), L::load(&in.positionY[i]), L::load(&in.positionZ[i]) },
+    };
+
+    V world[4][4];
+    for (int j = 0; j < 4; j++) {
+        for (int r = 0; r < 3; r++) {
+            V sum = L::mul(placement[0][r], L::set(parent[j][0]));
+            sum = L::mulAdd(placement[1][r], L::set(parent[j][1]), sum);
+            sum = L::mulAdd(placement[2][r], L::set(parent[j][2]), sum);
+            world[j][r] = L::mulAdd(placement[3][r], L::set(parent[j][3]), sum);
+        }
+        world[j][3] = L::set(parent[j][3]);
+    }
+
+    const size_t matrixStride = sizeof(glm::mat4) / sizeof(float);
+    float* worldOut = &out.world[i][0][0];
+    float* mvpOut = &out.mvp[i][0][0];
+    for (int j = 0; j < 4; j++) {
+        V clip[4];
+        for (int r = 0; r < 4; r++) {
+            V sum = L::mul(L::set(viewProjection[0][r]), world[j][0]);
+            sum = L::mulAdd(L::set(viewProjection[1][r]), world[j][1], sum);
+            sum = L::mulAdd(L::set(viewProjection[2][r]), world[j][2], sum);
+            clip[r] = L::mulAdd(L::set(viewProjection[3][r]), world[j][3], sum);
+        }
+        L::storeColumn(world[j][0], world[j][1], world[j][2], world[j][3], worldOut + j * 4, matrixStride);
+        L::storeColumn(clip[0], clip[1], clip[2], clip[3], mvpOut + j * 4, matrixStride);
+    }
+
+    // Sphere centre through world; the radius grows with the (uniform) scale
+    V cx = L::load(&in.sphereX[i]), cy = L::load(&in.sphereY[i]), cz = L::load(&in.sphereZ[i]);
+    float* centers[3] = { &out.sphereX[i], &out.sphereY[i], &out.sphereZ[i] };
+    for (int r = 0; r < 3; r++) {
+        V center = L::mulAdd(world[0][r], cx, world[3][r]);
+        center = L::mulAdd(world[1][r], cy, center);
+        L::store(centers[r], L::mulAdd(world[2][r], cz, center));
+    }
+    V scaleSquared = L::mul(world[0][0], world[0][0]);
+    scaleSquared = L::mulAdd(world[0][1], world[0][1], scaleSquared);
+    scaleSquared = L::mulAdd(world[0][2], world[0][2], scaleSquared);
+    L::store(&out.sphereRadius[i], L::mul(L::load(&in.sphereRadius[i]), L::sqrt(scaleSquared)));
+}
+
+void transformBatch(const TransformInputs& inputs, const glm::mat4& parent, const glm::mat4& viewProjection,
+                    TransformOutputs& outputs, size_t begin, size_t end) {
+    size_t i = begin;
+#if BATCH_TRANSFORM_AVX2 || BATCH_TRANSFORM_SSE2 || BATCH_TRANSFORM_NEON
+    for (; i + SimdLanes::kWidth <= end; i += SimdLanes::kWidth) {
+        transformLanes<SimdLanes>(inputs, parent, viewProjection, outputs, i);
+    }
+#endif
+    for (; i < end; i++) {
+        transformLanes<ScalarLanes>(inputs, parent, viewProjection, outputs, i);
+    }
+}
+
+void transformBatchScalar(const TransformInputs& inputs, const glm::mat4& parent, const glm::mat4& viewProjection,
+                          TransformOutputs& outputs, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        ObjectPlacement placement;
+        placement.position = glm::vec3(inputs.positionX[i], inputs.positionY[i], inputs.positionZ[i]);
+        placement.angleY = inputs.angleY[i];
+        placement.angleZ = inputs.angleZ[i];
+        placement.scale = inputs.scale[i];
+        glm::mat4 world = placementMatrix(placement) * parent;
+        outputs.world[i] = world;
+        outputs.mvp[i] = viewProjection * world;
+        glm::vec3 center = glm::vec3(world * glm::vec4(inputs.sphereX[i], inputs.sphereY[i], inputs.sphereZ[i], 1.0f));
+        outputs.sphereX[i] = center.x;
+        outputs.sphereY[i] = center.y;
+        outputs.sphereZ[i] = center.z;
+        outputs.sphereRadius[i] = inputs.sphereRadius[i] * glm::length(glm::vec3(world[0]));
+    }
+}
+
+const char* transformKernelName() {
+#if BATCH_TRANSFORM_AVX2
+    return "AVX2";
+#elif BATCH_TRANSFORM_SSE2
+    return "SSE2";
+#elif BATCH_TRANSFORM_NEON
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
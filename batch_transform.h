@@ -0,0 +1,60 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Where one object sits: translate(position) * rotateY(angleY) * rotateZ(angleZ)
+// * scale(scale), the same Euler order the viewer uses for its own rotation
+struct ObjectPlacement {
+    glm::vec3 position = glm::vec3(0.0f);
+    float angleY = 0.0f;
+    float angleZ = 0.0f;
+    float scale = 1.0f;
+};
+
+// The placement as a matrix, built with glm; the reference the kernels match
+glm::mat4 placementMatrix(const ObjectPlacement& placement);
+
+// Per-object placements and object-space bounding spheres, one array per
+// component so a kernel loads a full register of objects at a time
+struct TransformInputs {
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> angleY, angleZ, scale;
+    std::vector<float> sphereX, sphereY, sphereZ, sphereRadius;
+
+    void add(const ObjectPlacement& placement, const Bounds& bounds);
+    size_t size() const { return positionX.size(); }
+};
+
+// World and clip matrices per object, and world-space bounding spheres (SoA,
+// for culling). The placements are rotation and uniform scale only, so the
+// upper 3x3 of `world` doubles as the normal matrix, as computeNormalMatrix's
+// shortcut does.
+struct TransformOutputs {
+    std::vector<glm::mat4> world;
+    std::vector<glm::mat4> mvp;
+    std::vector<float> sphereX, sphereY, sphereZ, sphereRadius;
+
+    void resize(size_t count);
+};
+
+// Objects per parallelFor range; smaller batches cost more in handoff than
+// they win back on another core
+const size_t kTransformBatchGrain = 2048;
+
+// For objects [begin, end): world = placement * parent, mvp = viewProjection *
+// world, and the bounding sphere through world. `outputs` must already be
+// sized, and disjoint ranges may run on different threads. Uses AVX2 (8 objects
+// per step), SSE2 or NEON (4) when the build targets them, scalar code otherwise.
+void transformBatch(const TransformInputs& inputs, const glm::mat4& parent, const glm::mat4& viewProjection,
+                    TransformOutputs& outputs, size_t begin, size_t end);
+
+// The same results one object at a time with glm, for comparison
+void transformBatchScalar(const TransformInputs& inputs, const glm::mat4& parent, const glm::mat4& viewProjection,
+                          TransformOutputs& outputs, size_t begin, size_t end);
+
+// "AVX2", "SSE2", "NEON" or "scalar"
+const char* transformKernelName();
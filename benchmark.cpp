@@ -0,0 +1,397 @@
+#include "benchmark.h"
+#include "batch_transform.h"
+#include "obj_loader.h"
+#include "thread_pool.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Output of the original loader: unwelded positions plus one normal per corner
+struct LegacyMesh {
+    std::vector<float> vertices;
+    std::vector<float> normals;
+    std::vector<unsigned int> indices;
+};
+
+// The original line-by-line loader, kept only as the baseline for the benchmark
+static LegacyMesh loadOBJIstream(const char* path) {
+    LegacyMesh mesh;
+    std::ifstream file(path);
+    std::string line;
+    std::vector<glm::vec3> tempVertices;
+    std::vector<glm::vec3> tempNormals;
+
+    while (std::getline(file, line)) {
+        if (line.substr(0, 2) == "v ") {
+            std::istringstream ss(line.substr(2));
+            glm::vec3 vertex;
+            ss >> vertex.x >> vertex.y >> vertex.z;
+            tempVertices.push_back(vertex);
+        }
+        else if (line.substr(0, 3) == "vn ") {
+            std::istringstream ss(line.substr(3));
+            glm::vec3 normal;
+            ss >> normal.x >> normal.y >> normal.z;
+            tempNormals.push_back(normal);
+        }
+        else if (line.substr(0, 2) == "f ") {
+            std::istringstream ss(line.substr(2));
+            std::string token;
+            std::vector<unsigned int> faceVerts, faceNormals;
+
+            while (ss >> token) {
+                size_t pos1 = token.find('/');
+                size_t pos2 = token.find('/', pos1 + 1);
+                unsigned int v = std::stoul(token.substr(0, pos1)) - 1;
+                unsigned int n = std::stoul(token.substr(pos2 + 1)) - 1;
+                faceVerts.push_back(v);
+                faceNormals.push_back(n);
+            }
+
+            for (size_t i = 1; i < faceVerts.size() - 1; i++) {
+                mesh.indices.push_back(faceVerts[0]);
+                mesh.indices.push_back(faceVerts[i]);
+                mesh.indices.push_back(faceVerts[i + 1]);
+
+                for (int j = 0; j < 3; j++) {
+                    glm::vec3 normal = tempNormals[faceNormals[j]];
+                    mesh.normals.push_back(normal.x);
+                    mesh.normals.push_back(normal.y);
+                    mesh.normals.push_back(normal.z);
+                }
+            }
+        }
+    }
+
+    for (auto& vertex : tempVertices) {
+        mesh.vertices.push_back(vertex.x);
+        mesh.vertices.push_back(vertex.y);
+        mesh.vertices.push_back(vertex.z);
+    }
+
+    return mesh;
+}
+
+// Runs the loader `iterations` times and returns the median wall time in ms
+template <typename Loader, typename Result>
+static double timeLoader(Loader loader, const char* path, int iterations, Result& result) {
+    std::vector<double> times;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        result = loader(path);
+        auto stop = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int runLoadBenchmark(const char* path, int iterations) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "Failed to open OBJ file: " << path << std::endl;
+        return -1;
+    }
+    double megabytes = static_cast<double>(file.tellg()) / (1024.0 * 1024.0);
+    iterations = std::max(iterations, 1);
+
+    LegacyMesh baseline;
+    Mesh fast, threaded;
+    unsigned int threads = std::max(std::thread::hardware_concurrency(), 1u);
+    double baselineMs = timeLoader(loadOBJIstream, path, iterations, baseline);
+    double fastMs = timeLoader([](const char* file) { return loadOBJ(file, 1); }, path, iterations, fast);
+    double threadedMs = timeLoader([threads](const char* file) { return loadOBJ(file, threads); }, path, iterations, threaded);
+
+    // The welded mesh renumbers vertices, so compare the position of every corner
+    bool identical = baseline.indices.size() == fast.indices.size();
+    for (size_t i = 0; identical && i < fast.indices.size(); i++) {
+        const float* expected = &baseline.vertices[baseline.indices[i] * 3];
+        const glm::vec3& actual = fast.vertices[fast.indices[i]].position;
+        identical = expected[0] == actual.x && expected[1] == actual.y && expected[2] == actual.z;
+    }
+    // Chunked parsing must reproduce the serial weld exactly
+    bool threadedIdentical = threaded.indices == fast.indices && threaded.vertices.size() == fast.vertices.size() &&
+        std::memcmp(threaded.vertices.data(), fast.vertices.data(), fast.vertices.size() * sizeof(Vertex)) == 0;
+    size_t baselineBytes = (baseline.vertices.size() + baseline.normals.size()) * sizeof(float);
+    size_t fastBytes = fast.vertices.size() * sizeof(Vertex);
+
+    std::cout << path << ": " << fast.indices.size() / 3 << " triangles, "
+              << megabytes << " MB, " << iterations << " iterations (median)\n"
+              << "  istringstream: " << baselineMs << " ms (" << megabytes * 1000.0 / baselineMs << " MB/s)\n"
+              << "  loadOBJ:       " << fastMs << " ms (" << megabytes * 1000.0 / fastMs << " MB/s)\n"
+              << "  speedup:       " << baselineMs / fastMs << "x\n"
+              << "  threaded:      " << threadedMs << " ms (" << megabytes * 1000.0 / threadedMs << " MB/s, "
+              << threads << " threads, " << fastMs / threadedMs << "x over 1 thread)\n"
+              << "  vertex data:   " << baselineBytes << " bytes unwelded, " << fastBytes << " bytes welded ("
+              << fast.vertices.size() << " vertices)\n"
+              << "  output:        " << (identical ? "identical" : "MISMATCH") << ", threaded "
+              << (threadedIdentical ? "identical" : "MISMATCH") << std::endl;
+    return identical && threadedIdentical ? 0 : 1;
+}
+
+// Runs `transform` `iterations` times and returns the median wall time in ms
+static double timeTransforms(const std::function<void()>& transform, int iterations) {
+    std::vector<double> times;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        transform();
+        auto stop = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// Largest difference between two output sets, relative to the magnitude of
+// the reference value once that exceeds one
+static float maxTransformError(const TransformOutputs& a, const TransformOutputs& b) {
+    float error = 0.0f;
+    auto compare = [&error](float x, float reference) {
+        error = std::max(error, std::fabs(x - reference) / std::max(std::fabs(reference), 1.0f));
+    };
+    for (size_t i = 0; i < b.world.size(); i++) {
+        for (int j = 0; j < 4; j++) {
+            for (int r = 0; r < 4; r++) {
+                compare(a.world[i][j][r], b.world[i][j][r]);
+                compare(a.mvp[i][j][r], b.mvp[i][j][r]);
+            }
+        }
+        compare(a.sphereX[i], b.sphereX[i]);
+        compare(a.sphereY[i], b.sphereY[i]);
+        compare(a.sphereZ[i], b.sphereZ[i]);
+        compare(a.sphereRadius[i], b.sphereRadius[i]);
+    }
+    return error;
+}
+
+int runTransformBenchmark(size_t count, int iterations) {
+    count = std::max<size_t>(count, 1);
+    iterations = std::max(iterations, 1);
+
+    // Fixed seed, so every run transforms the same objects
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f), angle(-10.0f, 10.0f), scale(0.1f, 4.0f);
+    TransformInputs inputs;
+    for (size_t i = 0; i < count; i++) {
+        ObjectPlacement placement;
+        placement.position = glm::vec3(position(random), position(random), position(random));
+        placement.angleY = angle(random);
+        placement.angleZ = angle(random);
+        placement.scale = scale(random);
+        Bounds bounds;
+        bounds.center = glm::vec3(scale(random), scale(random), scale(random));
+        bounds.radius = scale(random);
+        inputs.add(placement, bounds);
+    }
+    glm::mat4 parent = glm::rotate(glm::rotate(glm::mat4(1.0f), 0.3f, glm::vec3(0.0f, 1.0f, 0.0f)), 0.2f, glm::vec3(0.0f, 0.0f, 1.0f));
+    glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f) *
+        glm::lookAt(glm::vec3(30.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    TransformOutputs reference, batched, threaded;
+    reference.resize(count);
+    batched.resize(count);
+    threaded.resize(count);
+    ThreadPool pool;
+    double scalarMs = timeTransforms([&] { transformBatchScalar(inputs, parent, viewProjection, reference, 0, count); }, iterations);
+    double batchedMs = timeTransforms([&] { transformBatch(inputs, parent, viewProjection, batched, 0, count); }, iterations);
+    double threadedMs = timeTransforms([&] {
+        pool.parallelFor(count, kTransformBatchGrain, [&](size_t begin, size_t end) {
+            transformBatch(inputs, parent, viewProjection, threaded, begin, end);
+        });
+    }, iterations);
+
+    // The polynomial sin/cos and fused multiply-adds round differently from glm
+    const float tolerance = 1e-4f;
+    float batchedError = maxTransformError(batched, reference);
+    float threadedError = maxTransformError(threaded, reference);
+    bool matches = batchedError <= tolerance && threadedError <= tolerance;
+    double perObject = 1e6 / static_cast<double>(count);
+    std::cout << count << " objects, " << iterations << " iterations (median)\n"
+              << "  glm:             " << scalarMs << " ms (" << scalarMs * perObject << " ns/object)\n"
+              << "  batched:         " << batchedMs << " ms (" << batchedMs * perObject << " ns/object, "
+              << transformKernelName() << ", " << scalarMs / batchedMs << "x)\n"
+              << "  threaded batch:  " << threadedMs << " ms (" << pool.threadCount() << " threads, "
+              << scalarMs / threadedMs << "x over glm)\n"
+              << "  max error:       " << batchedError << ", threaded " << threadedError
+              << (matches ? "" : " MISMATCH") << std::endl;
+    return matches ? 0 : 1;
+}
+
+static const unsigned int kBenchmarkLatency = 3;
+
+void benchmarkCamera(unsigned int frame, unsigned int frameCount, float& angleY, float& angleZ, float& cameraDistance) {
+    const float twoPi = 6.28318531f;
+    float t = frameCount > 1 ? static_cast<float>(frame) / static_cast<float>(frameCount - 1) : 0.0f;
+    angleY = twoPi * t;
+    angleZ = 0.25f * std::sin(twoPi * t);
+    cameraDistance = 5.0f + 35.0f * (0.5f - 0.5f * std::cos(twoPi * t));
+}
+
+static double secondsNow() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool FrameBenchmark::create(int targetWidth, int targetHeight, unsigned int frameCount, unsigned int warmupFrames) {
+    width = targetWidth;
+    height = targetHeight;
+    frames = frameCount + warmupFrames;
+    warmup = warmupFrames;
+    frame = 0;
+    frameMs.clear();
+    primitives.assign(frames, 0);
+
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Benchmark framebuffer " << width << "x" << height << " is incomplete (0x" << std::hex << status << std::dec << ")" << std::endl;
+        return false;
+    }
+
+    queries.resize(kBenchmarkLatency);
+    glGenQueries(kBenchmarkLatency, queries.data());
+    lastFrameEnd = secondsNow();
+    return true;
+}
+
+void FrameBenchmark::destroy() {
+    if (!queries.empty()) glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &colorBuffer);
+    glDeleteRenderbuffers(1, &depthBuffer);
+    *this = FrameBenchmark();
+}
+
+void FrameBenchmark::beginFrame() {
+    // The query about to be reused belongs to kBenchmarkLatency frames ago
+    unsigned int query = queries[frame % kBenchmarkLatency];
+    if (frame >= kBenchmarkLatency) {
+        GLuint64 count = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &count);
+        primitives[frame - kBenchmarkLatency] = count;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
+}
+
+void FrameBenchmark::beginShading() {
+    glBeginQuery(GL_PRIMITIVES_GENERATED, queries[frame % kBenchmarkLatency]);
+}
+
+void FrameBenchmark::endShading() {
+    glEndQuery(GL_PRIMITIVES_GENERATED);
+}
+
+void FrameBenchmark::endFrame() {
+    double now = secondsNow();
+    if (frame == warmup) {
+        measureStart = lastFrameEnd;
+    }
+    if (frame >= warmup) {
+        frameMs.push_back((now - lastFrameEnd) * 1000.0);
+        measureEnd = now;
+    }
+    lastFrameEnd = now;
+    frame++;
+}
+
+std::string jsonString(const char* text) {
+    std::string quoted = "\"";
+    for (const char* p = text ? text : ""; *p; p++) {
+        if (*p == '"' || *p == '\\') quoted += '\\';
+        if (static_cast<unsigned char>(*p) >= 0x20) quoted += *p;
+    }
+    return quoted + "\"";
+}
+
+bool FrameBenchmark::writeJson(const std::string& path, const Options& options, size_t meshCount, size_t instanceCount) {
+    for (unsigned int i = frame > kBenchmarkLatency ? frame - kBenchmarkLatency : 0; i < frame; i++) {
+        GLuint64 count = 0;
+        glGetQueryObjectui64v(queries[i % kBenchmarkLatency], GL_QUERY_RESULT, &count);
+        primitives[i] = count;
+    }
+
+    std::vector<double> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    // Nearest-rank percentile
+    auto percentile = [&sorted](double p) {
+        if (sorted.empty()) return 0.0;
+        size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+        return sorted[std::min(rank > 0 ? rank - 1 : 0, sorted.size() - 1)];
+    };
+    double seconds = measureEnd - measureStart;
+    unsigned long long triangles = 0;
+    for (unsigned int i = warmup; i < frame; i++) triangles += primitives[i];
+    size_t measured = frameMs.size();
+    double average = 0.0;
+    for (double ms : frameMs) average += ms;
+    average = measured ? average / measured : 0.0;
+
+    const char* modeNames[] = { "single", "instanced", "indirect" };
+    std::ostringstream out;
+    out << "{\n"
+        << "  \"renderer\": " << jsonString(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) << ",\n"
+        << "  \"gl_version\": " << jsonString(reinterpret_cast<const char*>(glGetString(GL_VERSION))) << ",\n"
+        << "  \"draw_mode\": \"" << modeNames[static_cast<int>(options.drawMode)] << "\",\n"
+        << "  \"layout\": \"" << vertexLayoutName(options.layout) << "\",\n"
+        << "  \"gpu_cull\": " << (options.gpuCull ? "true" : "false") << ",\n"
+        << "  \"meshlets\": " << (options.meshlets ? "true" : "false") << ",\n"
+        << "  \"outline\": " << (options.outline ? "true" : "false") << ",\n"
+        << "  \"depth_prepass\": " << (options.depthPrepass ? "true" : "false") << ",\n"
+        << "  \"lights\": " << options.lightCount << ",\n"
+        << "  \"shadow_cascades\": " << (options.shadows ? options.shadowCascades : 0) << ",\n"
+        << "  \"shadow_resolution\": " << options.shadowResolution << ",\n"
+        << "  \"lod_error\": " << options.lodThreshold << ",\n"
+        << "  \"meshes\": [";
+    for (size_t i = 0; i < options.meshPaths.size(); i++) {
+        out << (i ? ", " : "") << jsonString(options.meshPaths[i].c_str());
+    }
+    out << "],\n"
+        << "  \"mesh_count\": " << meshCount << ",\n"
+        << "  \"instances\": " << instanceCount << ",\n"
+        << "  \"resolution\": [" << width << ", " << height << "],\n"
+        << "  \"warmup_frames\": " << warmup << ",\n"
+        << "  \"frames\": " << measured << ",\n"
+        << "  \"seconds\": " << seconds << ",\n"
+        << "  \"fps\": " << (seconds > 0.0 ? measured / seconds : 0.0) << ",\n"
+        << "  \"frame_ms\": { \"min\": " << percentile(0.0) << ", \"avg\": " << average
+        << ", \"p50\": " << percentile(0.5) << ", \"p90\": " << percentile(0.9)
+        << ", \"p99\": " << percentile(0.99) << ", \"max\": " << (sorted.empty() ? 0.0 : sorted.back()) << " },\n"
+        << "  \"triangles_per_frame\": " << (measured ? triangles / measured : 0) << ",\n"
+        << "  \"triangles_per_second\": " << (seconds > 0.0 ? triangles / seconds : 0.0) << "\n"
+        << "}\n";
+
+    if (path.empty()) {
+        std::cout << out.str() << std::flush;
+        return true;
+    }
+    std::ofstream file(path);
+    if (!file || !(file << out.str())) {
+        std::cerr << "Failed to write benchmark results: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "options.h"
+
+#include <string>
+#include <vector>
+
+// Times loadOBJ against the original istringstream parser on the same file, and
+// the single-threaded loadOBJ against the chunked one. Checks that the triangles
+// match and that the threaded mesh is bit-identical. Returns the process exit code.
+int runLoadBenchmark(const char* path, int iterations);
+
+// Times `count` random object transforms through transformBatchScalar (glm, one
+// object at a time), transformBatch on one thread and transformBatch split
+// across a ThreadPool, and checks the SIMD results against glm. Returns the
+// process exit code.
+int runTransformBenchmark(size_t count, int iterations);
+
+// `text` as a quoted JSON string, with quotes and backslashes escaped and
+// control characters dropped; null gives ""
+std::string jsonString(const char* text);
+
+// Frames rendered before measuring starts, to get shader compiles and driver
+// warm-up out of the numbers
+const unsigned int kBenchmarkWarmupFrames = 60;
+
+// Scripted camera for --benchmark: one full turn about Y with a slow tilt,
+// while the camera pulls out from 5 to 40 units and back, so every LOD switch
+// and cull state of the default scene is crossed
+void benchmarkCamera(unsigned int frame, unsigned int frameCount, float& angleY, float& angleZ, float& cameraDistance);
+
+// Offscreen target and measurements for --benchmark. Every frame renders into an
+// FBO of the requested size; wall time between frames and GL_PRIMITIVES_GENERATED
+// of the shading pass (read back kBenchmarkLatency frames late) are recorded once
+// the warm-up is over.
+class FrameBenchmark {
+public:
+    bool create(int width, int height, unsigned int frameCount, unsigned int warmupFrames);
+    void destroy();
+
+    // Binds the FBO and viewport
+    void beginFrame();
+    // Bracket the shading draws only, once per frame, so the depth pre-pass,
+    // shadow casters and full-screen passes do not count as scene triangles
+    void beginShading();
+    void endShading();
+    void endFrame();
+    bool done() const { return frame >= frames; }
+    unsigned int frameIndex() const { return frame; }
+    unsigned int framebuffer() const { return fbo; }
+
+    // Reads the counts still in flight and writes the results as JSON to `path`,
+    // or to stdout when it is empty
+    bool writeJson(const std::string& path, const Options& options, size_t meshCount, size_t instanceCount);
+
+private:
+    unsigned int fbo = 0;
+    unsigned int colorBuffer = 0;
+    unsigned int depthBuffer = 0;
+    int width = 0;
+    int height = 0;
+    unsigned int frames = 0;
+    unsigned int warmup = 0;
+    unsigned int frame = 0;
+    double lastFrameEnd = 0.0;
+    double measureStart = 0.0;
+    double measureEnd = 0.0;
+    std::vector<double> frameMs;
+    std::vector<unsigned long long> primitives;
+    std::vector<unsigned int> queries;
+};
@@ -0,0 +1,169 @@
+#include "clustered_lights.h"
+#include "shaders.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+static const unsigned int kClusterGroupSize = 64;
+static const unsigned int kClusterCount = kClusterGridX * kClusterGridY * kClusterGridZ;
+
+// Storage bindings; the culls use 0-5, which they rebind every dispatch
+static const unsigned int kLightBinding = 6;
+static const unsigned int kCellBinding = 7;
+static const unsigned int kIndexBinding = 8;
+static const unsigned int kBoundsBinding = 9;
+
+static unsigned int createBuffer(GLenum target, size_t size, const void* data, GLenum usage) {
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    glBufferData(target, size, data, usage);
+    return buffer;
+}
+
+void ClusteredLights::create(ProgramCache& programs, const std::vector<LightData>& lightData) {
+    program = programs.program(programs.requestCompute(clusterCullComputeShaderSource));
+    bindUniformBlock(program, "FrameData", kFrameDataBinding);
+    bindUniformBlock(program, "ClusterData", kClusterDataBinding);
+
+    lights = static_cast<unsigned int>(lightData.size());
+    lightBuffer = createBuffer(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(lightData.size(), 1) * sizeof(LightData), lightData.data(), GL_STATIC_DRAW);
+    boundsBuffer = createBuffer(GL_SHADER_STORAGE_BUFFER, kClusterCount * 2 * sizeof(glm::vec4), nullptr, GL_STATIC_DRAW);
+    cellBuffer = createBuffer(GL_SHADER_STORAGE_BUFFER, kClusterCount * sizeof(glm::uvec2), nullptr, GL_DYNAMIC_COPY);
+    // The running count, then room for every cluster to hold its maximum, so the
+    // atomic allocation in the cull can never run past the end
+    size_t perCluster = std::min<size_t>(std::max(lights, 1u), kMaxLightsPerCluster);
+    indexBuffer = createBuffer(GL_SHADER_STORAGE_BUFFER, (1 + kClusterCount * perCluster) * sizeof(unsigned int), nullptr, GL_DYNAMIC_COPY);
+    clusterDataBuffer = createBuffer(GL_UNIFORM_BUFFER, sizeof(ClusterUniforms), nullptr, GL_DYNAMIC_DRAW);
+}
+
+void ClusteredLights::destroy() {
+    // The program belongs to the ProgramCache
+    program = ShaderProgram();
+    for (unsigned int* buffer : { &lightBuffer, &boundsBuffer, &cellBuffer, &indexBuffer, &clusterDataBuffer }) {
+        glDeleteBuffers(1, buffer);
+    }
+    *this = ClusteredLights();
+}
+
+// View-space box of every froxel. Slice k spans depths near * (far / near)^(k / Z)
+// to the next one, so froxels stay roughly cubic instead of turning into long
+// slabs far from the camera. A tile's corners at a depth d in NDC x come back
+// as x_view = (x_ndc + P[2][0]) * d / P[0][0], and the same for y.
+void ClusteredLights::buildGrid(const glm::mat4& projection, float nearPlane, float farPlane) {
+    gridProjection = projection;
+    std::vector<glm::vec4> bounds(kClusterCount * 2);
+    for (unsigned int z = 0; z < kClusterGridZ; z++) {
+        float depths[2] = {
+            nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z) / kClusterGridZ),
+            nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z + 1) / kClusterGridZ) };
+        for (unsigned int y = 0; y < kClusterGridY; y++) {
+            for (unsigned int x = 0; x < kClusterGridX; x++) {
+                glm::vec3 low(INFINITY), high(-INFINITY);
+                for (float depth : depths) {
+                    for (unsigned int corner = 0; corner < 4; corner++) {
+                        float ndcX = -1.0f + 2.0f * static_cast<float>(x + (corner & 1)) / kClusterGridX;
+                        float ndcY = -1.0f + 2.0f * static_cast<float>(y + (corner >> 1)) / kClusterGridY;
+                        glm::vec3 point((ndcX + projection[2][0]) * depth / projection[0][0],
+                                        (ndcY + projection[2][1]) * depth / projection[1][1], -depth);
+                        low = glm::min(low, point);
+                        high = glm::max(high, point);
+                    }
+                }
+                unsigned int cluster = (z * kClusterGridY + y) * kClusterGridX + x;
+                bounds[cluster * 2] = glm::vec4(low, 0.0f);
+                bounds[cluster * 2 + 1] = glm::vec4(high, 0.0f);
+            }
+        }
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, boundsBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bounds.size() * sizeof(glm::vec4), bounds.data());
+}
+
+void ClusteredLights::cull(const glm::mat4& projection, float nearPlane, float farPlane, int width, int height) {
+    if (projection != gridProjection) {
+        buildGrid(projection, nearPlane, farPlane);
+        gridWidth = 0;
+    }
+
+    // The fragment shader's froxel lookup: slice = log(depth) * z + w
+    if (width != gridWidth || height != gridHeight) {
+        gridWidth = width;
+        gridHeight = height;
+        float slicesPerLog = static_cast<float>(kClusterGridZ) / std::log(farPlane / nearPlane);
+        ClusterUniforms cluster;
+        cluster.grid = glm::uvec4(kClusterGridX, kClusterGridY, kClusterGridZ, lights);
+        cluster.scale = glm::vec4(static_cast<float>(kClusterGridX) / std::max(width, 1),
+                                  static_cast<float>(kClusterGridY) / std::max(height, 1),
+                                  slicesPerLog, -slicesPerLog * std::log(nearPlane));
+        glBindBuffer(GL_UNIFORM_BUFFER, clusterDataBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(cluster), &cluster);
+    }
+    glBindBufferBase(GL_UNIFORM_BUFFER, kClusterDataBinding, clusterDataBuffer);
+
+    // Cleared on the GPU; a glBufferSubData would wait for last frame's shading
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, indexBuffer);
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, sizeof(unsigned int), GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+    glUseProgram(program.id);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kBoundsBinding, boundsBuffer);
+    bind();
+    glDispatchCompute((kClusterCount + kClusterGroupSize - 1) / kClusterGroupSize, 1, 1);
+
+    // The shading pass reads the lists from its fragment shader
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void ClusteredLights::bind() const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kLightBinding, lightBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kCellBinding, cellBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kIndexBinding, indexBuffer);
+}
+
+// Hue around the colour wheel, like the instance colours but independent of them
+static glm::vec3 lightColor(std::mt19937& random) {
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    float hue = unit(random) * 6.0f;
+    float x = 1.0f - std::fabs(std::fmod(hue, 2.0f) - 1.0f);
+    switch (static_cast<int>(hue)) {
+    case 0: return glm::vec3(1.0f, x, 0.0f);
+    case 1: return glm::vec3(x, 1.0f, 0.0f);
+    case 2: return glm::vec3(0.0f, 1.0f, x);
+    case 3: return glm::vec3(0.0f, x, 1.0f);
+    case 4: return glm::vec3(x, 0.0f, 1.0f);
+    default: return glm::vec3(1.0f, 0.0f, x);
+    }
+}
+
+std::vector<LightData> buildLightField(size_t count, const Bounds& bounds) {
+    std::vector<LightData> lights(count);
+    std::mt19937 random(4321);
+    // The instance field spreads over about one mesh footprint; lights go a
+    // little beyond it and above it
+    glm::vec3 extent = (bounds.max - bounds.min) * 0.75f;
+    glm::vec3 low = bounds.center - extent, high = bounds.center + extent;
+    high.y += extent.y;
+    std::uniform_real_distribution<float> x(low.x, high.x), y(low.y, high.y), z(low.z, high.z);
+    std::uniform_real_distribution<float> tilt(-0.5f, 0.5f);
+
+    // About the same number of lights overlap any point for any count
+    float range = glm::length(high - low) * 0.6f / std::cbrt(static_cast<float>(std::max<size_t>(count, 1)));
+    const float innerCos = std::cos(glm::radians(25.0f));
+    const float outerCos = std::cos(glm::radians(40.0f));
+    for (size_t i = 0; i < count; i++) {
+        LightData& light = lights[i];
+        light.positionRange = glm::vec4(x(random), y(random), z(random), range);
+        light.color = glm::vec4(lightColor(random) * 0.8f, innerCos);
+        if (i % 2) {
+            // Spots reach further along their axis to light as much as a point light
+            light.positionRange.w = range * 1.5f;
+            light.spotDirection = glm::vec4(glm::normalize(glm::vec3(tilt(random), -1.0f, tilt(random))), outerCos);
+        }
+        else {
+            light.spotDirection = glm::vec4(0.0f, -1.0f, 0.0f, -1.0f);
+        }
+    }
+    return lights;
+}
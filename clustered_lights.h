@@ -0,0 +1,57 @@
+#pragma once
+
+#include "mesh.h"
+#include "program_cache.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+// std430 mirror of one Light in the clustered shaders. Point lights have
+// spotDirection.w at -1, so every direction is inside the cone.
+struct LightData {
+    glm::vec4 positionRange;  // world position, w: distance where the light reaches zero
+    glm::vec4 color;          // rgb intensity, w: cosine of the spot's inner angle
+    glm::vec4 spotDirection;  // world direction, w: cosine of the spot's outer angle
+};
+
+// Clustered forward lighting for many point and spot lights. The view frustum
+// is cut into a kClusterGridX x kClusterGridY x kClusterGridZ grid of froxels,
+// screen tiles split into slices that grow exponentially with depth. Each frame
+// a compute pass tests every light's sphere against every froxel and writes
+// compact per-cluster index lists; the fragment shader finds its froxel from
+// gl_FragCoord and view depth and loops over that list only. Needs a 4.3
+// context.
+class ClusteredLights {
+public:
+    void create(ProgramCache& programs, const std::vector<LightData>& lights);
+    void destroy();
+
+    // Rebuilds the froxel bounds when the projection changed, refreshes
+    // ClusterData for the viewport and bins the lights. FrameData must be bound,
+    // as the lights move into view space with its view matrix.
+    void cull(const glm::mat4& projection, float nearPlane, float farPlane, int width, int height);
+
+    // Binds the buffers the clustered fragment shader reads; they stay bound
+    void bind() const;
+
+    size_t lightCount() const { return lights; }
+
+private:
+    void buildGrid(const glm::mat4& projection, float nearPlane, float farPlane);
+
+    ShaderProgram program;
+    glm::mat4 gridProjection = glm::mat4(0.0f);
+    int gridWidth = 0;
+    int gridHeight = 0;
+    unsigned int lightBuffer = 0;
+    unsigned int boundsBuffer = 0;
+    unsigned int cellBuffer = 0;
+    unsigned int indexBuffer = 0;
+    unsigned int clusterDataBuffer = 0;
+    unsigned int lights = 0;
+};
+
+// `count` lights at fixed pseudo-random places around `bounds` (the scene's
+// footprint), every other one a spot pointing mostly down. Their range shrinks
+// as the count grows, so each surface sees a handful whatever the count.
+std::vector<LightData> buildLightField(size_t count, const Bounds& bounds);
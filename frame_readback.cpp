@@ -0,0 +1,272 @@
+#include "frame_readback.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+void FrameReadback::create(unsigned int ringSize, FrameSink frameSink, bool dropWhenBehind) {
+    sink = std::move(frameSink);
+    dropFrames = dropWhenBehind;
+    slots.resize(std::max(ringSize, 2u));
+    persistent = GLAD_GL_VERSION_4_4 != 0;
+    stopping = false;
+    captured = dropped = delivered = 0;
+    thread = std::thread(&FrameReadback::run, this);
+}
+
+void FrameReadback::destroy() {
+    if (thread.joinable()) {
+        drain();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        queued.notify_all();
+        thread.join();
+    }
+    releaseSlots();
+    slots.clear();
+    if (fbo) {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &colorBuffer);
+        glDeleteRenderbuffers(1, &depthBuffer);
+    }
+    fbo = colorBuffer = depthBuffer = 0;
+    targetWidth = targetHeight = 0;
+    sink = FrameSink();
+    next = 0;
+}
+
+void FrameReadback::bindTarget(int width, int height) {
+    if (width != targetWidth || height != targetHeight) {
+        targetWidth = width;
+        targetHeight = height;
+        if (!fbo) {
+            glGenFramebuffers(1, &fbo);
+            glGenRenderbuffers(1, &colorBuffer);
+            glGenRenderbuffers(1, &depthBuffer);
+        }
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Readback framebuffer " << width << "x" << height << " is incomplete (0x" << std::hex << status << std::dec << ")" << std::endl;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, targetWidth, targetHeight);
+}
+
+void FrameReadback::presentTarget() const {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, targetWidth, targetHeight, 0, 0, targetWidth, targetHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void FrameReadback::allocateSlots(int width, int height) {
+    slotWidth = width;
+    slotHeight = height;
+    size_t size = static_cast<size_t>(width) * height * 4;
+    for (Slot& slot : slots) {
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        if (persistent) {
+            const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_PIXEL_PACK_BUFFER, size, nullptr, flags);
+            slot.mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, flags));
+        }
+        else {
+            glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        }
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    next = 0;
+}
+
+// Only called with every slot Free, after drain()
+void FrameReadback::releaseSlots() {
+    for (Slot& slot : slots) {
+        if (slot.mapped) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        if (slot.buffer) glDeleteBuffers(1, &slot.buffer);
+        slot = Slot();
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slotWidth = slotHeight = 0;
+}
+
+void FrameReadback::collect(bool wait) {
+    // Reads were issued round-robin from `next` and their fences pass in that
+    // order, so the first unfinished one ends the scan
+    for (size_t i = 0; i < slots.size(); i++) {
+        Slot& slot = slots[(next + i) % slots.size()];
+        std::unique_lock<std::mutex> lock(mutex);
+        if (slot.state == SlotState::Released) {
+            lock.unlock();
+            if (!persistent) {
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                slot.mapped = nullptr;
+            }
+            lock.lock();
+            slot.state = SlotState::Free;
+            continue;
+        }
+        if (slot.state != SlotState::Reading) {
+            continue;
+        }
+        lock.unlock();
+
+        GLsync fence = static_cast<GLsync>(slot.fence);
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (wait && result == GL_TIMEOUT_EXPIRED) {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+        if (result == GL_TIMEOUT_EXPIRED) {
+            break;
+        }
+        glDeleteSync(fence);
+        slot.fence = nullptr;
+        if (!persistent) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            slot.mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                static_cast<GLsizeiptr>(slotWidth) * slotHeight * 4, GL_MAP_READ_BIT));
+        }
+
+        lock.lock();
+        slot.state = SlotState::Queued;
+        queue.push_back(static_cast<unsigned int>(&slot - slots.data()));
+        lock.unlock();
+        queued.notify_one();
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void FrameReadback::drain() {
+    collect(true);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        released.wait(lock, [this] { return queue.empty() && std::none_of(slots.begin(), slots.end(),
+                                                                           [](const Slot& s) { return s.state == SlotState::Queued; }); });
+    }
+    collect(false);
+}
+
+void FrameReadback::capture(unsigned int framebuffer, int width, int height) {
+    if (width != slotWidth || height != slotHeight) {
+        drain();
+        releaseSlots();
+        allocateSlots(width, height);
+    }
+    collect(false);
+
+    // The slot about to be reused was read ringSize frames ago; if that read
+    // is somehow still running it is waited for, but a slot the sink still
+    // holds means the sink is behind and this frame is dropped, unless every
+    // frame must arrive
+    Slot& slot = slots[next];
+    SlotState state;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        state = slot.state;
+    }
+    if (state == SlotState::Reading) {
+        collect(true);
+        std::lock_guard<std::mutex> lock(mutex);
+        state = slot.state;
+    }
+    if (state == SlotState::Queued && !dropFrames) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            released.wait(lock, [&slot] { return slot.state != SlotState::Queued; });
+        }
+        collect(false);
+        std::lock_guard<std::mutex> lock(mutex);
+        state = slot.state;
+    }
+    if (state != SlotState::Free) {
+        dropped++;
+        return;
+    }
+
+    GLint readFramebuffer = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadBuffer(framebuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    // Into the bound buffer: returns as soon as the copy is queued
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    slot.state = SlotState::Reading;
+    slot.index = captured++;
+    next = (next + 1) % slots.size();
+}
+
+unsigned long long FrameReadback::deliveredFrames() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return delivered;
+}
+
+void FrameReadback::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        queued.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+        Slot& slot = slots[queue.front()];
+        queue.pop_front();
+        ReadbackFrame frame{ slot.mapped, slotWidth, slotHeight, slot.index };
+        lock.unlock();
+        if (frame.pixels) {
+            sink(frame);
+        }
+        lock.lock();
+        slot.state = SlotState::Released;
+        delivered++;
+        released.notify_all();
+    }
+}
+
+void writePpmFrame(std::ostream& out, const ReadbackFrame& frame) {
+    out << "P6\n" << frame.width << " " << frame.height << "\n255\n";
+    std::vector<unsigned char> row(static_cast<size_t>(frame.width) * 3);
+    // PPM runs top to bottom and has no alpha
+    for (int y = frame.height - 1; y >= 0; y--) {
+        const unsigned char* source = frame.pixels + static_cast<size_t>(y) * frame.width * 4;
+        for (int x = 0; x < frame.width; x++) {
+            row[x * 3] = source[x * 4];
+            row[x * 3 + 1] = source[x * 4 + 1];
+            row[x * 3 + 2] = source[x * 4 + 2];
+        }
+        out.write(reinterpret_cast<const char*>(row.data()), row.size());
+    }
+}
+
+FrameSink openPpmStreamSink(const std::string& path) {
+    std::shared_ptr<std::ofstream> file = std::make_shared<std::ofstream>(path, std::ios::binary);
+    if (!*file) {
+        std::cerr << "Cannot open " << path << " for the frame stream" << std::endl;
+        return FrameSink();
+    }
+    return [file](const ReadbackFrame& frame) {
+        writePpmFrame(*file, frame);
+        file->flush();
+    };
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One finished frame as the sink sees it: RGBA8 rows, bottom row first as GL
+// reads them. `pixels` points straight into the pixel buffer and is only valid
+// until the sink returns.
+struct ReadbackFrame {
+    const unsigned char* pixels;
+    int width;
+    int height;
+    unsigned long long index;  // frames captured before this one
+};
+
+using FrameSink = std::function<void(const ReadbackFrame&)>;
+
+// Gets rendered frames off the GPU without stalling the pipeline. Each capture
+// is a glReadPixels into the next of `ringSize` pixel buffer objects, fenced
+// and collected once the fence has passed, so frames arrive up to ringSize - 1
+// frames late instead of the CPU waiting for the GPU to finish. Collected
+// frames go to `sink` on a thread of their own, which reads the mapped buffer
+// in place (persistently mapped on 4.4+), and the slot is only reused once
+// the sink returns. A sink that falls behind costs dropped frames, never
+// render time or queue growth: at most the whole ring is waiting for it.
+// Batch jobs that need every frame can have capture() wait for it instead.
+class FrameReadback {
+public:
+    FrameReadback() = default;
+    ~FrameReadback() { destroy(); }
+    FrameReadback(const FrameReadback&) = delete;
+    FrameReadback& operator=(const FrameReadback&) = delete;
+
+    void create(unsigned int ringSize, FrameSink sink, bool dropWhenBehind = true);
+    // Delivers the frames still in flight, then stops the sink thread
+    void destroy();
+
+    // Binds an offscreen colour and depth target of this size, with the viewport
+    void bindTarget(int width, int height);
+    unsigned int framebuffer() const { return fbo; }
+    // Copies the target to the window's back buffer, so it shows what was sent
+    void presentTarget() const;
+
+    // Starts reading colour attachment 0 of `framebuffer` and hands any
+    // frames whose reads have finished to the sink
+    void capture(unsigned int framebuffer, int width, int height);
+
+    // Totals for the console report
+    unsigned long long capturedFrames() const { return captured; }
+    unsigned long long droppedFrames() const { return dropped; }
+    unsigned long long deliveredFrames() const;
+
+private:
+    enum class SlotState { Free, Reading, Queued, Released };
+    struct Slot {
+        unsigned int buffer = 0;
+        void* fence = nullptr;
+        unsigned char* mapped = nullptr;
+        SlotState state = SlotState::Free;
+        unsigned long long index = 0;
+    };
+
+    void allocateSlots(int width, int height);
+    void releaseSlots();
+    // Hands finished reads to the sink; with `wait` blocks until every read has finished
+    void collect(bool wait);
+    // Waits until the sink has returned every slot, then unmaps them
+    void drain();
+    void run();
+
+    FrameSink sink;
+    std::vector<Slot> slots;
+    unsigned int next = 0;
+    int slotWidth = 0;
+    int slotHeight = 0;
+    bool persistent = false;
+    bool dropFrames = true;
+
+    unsigned int fbo = 0;
+    unsigned int colorBuffer = 0;
+    unsigned int depthBuffer = 0;
+    int targetWidth = 0;
+    int targetHeight = 0;
+
+    std::thread thread;
+    mutable std::mutex mutex;
+    std::condition_variable queued;
+    std::condition_variable released;
+    std::deque<unsigned int> queue;
+    bool stopping = false;
+    unsigned long long captured = 0;
+    unsigned long long dropped = 0;
+    unsigned long long delivered = 0;
+};
+
+// Writes `frame` as one binary PPM, top row first and without alpha
+void writePpmFrame(std::ostream& out, const ReadbackFrame& frame);
+
+// Sink writing each frame to `path` as a binary PPM, one after another, which
+// encoders such as ffmpeg read as an image pipe. Returns an empty sink and
+// prints the error when the file cannot be opened.
+FrameSink openPpmStreamSink(const std::string& path);
@@ -0,0 +1,21 @@
+#include "gpu_mesh.h"
+
+MeshView makeMeshView(const Mesh& mesh, const PackedVertices& packed) {
+    MeshView view;
+    view.layout = packed.layout;
+    view.stride = packed.stride;
+    view.vertexData = packed.data.data();
+    view.vertexCount = mesh.vertices.size();
+    view.indexData = mesh.indices.data();
+    view.indexCount = mesh.indices.size();
+    view.bounds = mesh.bounds;
+    view.positionOffset = packed.positionOffset;
+    view.positionScale = packed.positionScale;
+    view.lods = mesh.lods;
+    view.meshletData = mesh.meshlets.data();
+    view.meshletCount = mesh.meshlets.size();
+    if (view.lods.empty()) {
+        view.lods.push_back(MeshLod{ 0, static_cast<unsigned int>(mesh.indices.size()), 0.0f });
+    }
+    return view;
+}
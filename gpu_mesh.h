@@ -0,0 +1,29 @@
+#pragma once
+
+#include "mesh.h"
+#include "vertex_format.h"
+
+#include <cstddef>
+#include <vector>
+
+// Borrowed, upload-ready mesh data: either a freshly packed Mesh or the ranges
+// of a memory-mapped mesh cache. Nothing is copied until it is added to a
+// MeshRegistry or streamed in by a MeshStreamer.
+struct MeshView {
+    VertexLayout layout = VertexLayout::Float;
+    unsigned int stride = 0;
+    const void* vertexData = nullptr;
+    size_t vertexCount = 0;
+    const unsigned int* indexData = nullptr;
+    size_t indexCount = 0;
+    Bounds bounds;
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+    // Always at least one level; ranges are relative to indexData
+    std::vector<MeshLod> lods;
+    // Ranges are relative to indexData; empty when none were built
+    const Meshlet* meshletData = nullptr;
+    size_t meshletCount = 0;
+};
+
+MeshView makeMeshView(const Mesh& mesh, const PackedVertices& packed);
@@ -0,0 +1,115 @@
+#include "instance_culler.h"
+#include "instancing.h"
+#include "shaders.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+
+// The compute shader reads InstanceData as 37 tightly packed floats
+static_assert(sizeof(InstanceData) == 37 * sizeof(float), "InstanceData layout changed");
+
+static const unsigned int kCullGroupSize = 64;
+
+// std430 mirror of CullMesh in the compute shader
+struct CullMesh {
+    glm::vec4 sphere;
+    float lodErrors[kMaxLods];
+    unsigned int lodCount;
+    unsigned int padding[3];
+};
+static_assert(kMaxLods == 4, "CullMesh.lodErrors is a vec4 in the compute shader");
+
+static unsigned int createBuffer(GLenum target, size_t size, const void* data, GLenum usage) {
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    glBufferData(target, size, data, usage);
+    return buffer;
+}
+
+void InstanceCuller::create(ProgramCache& programs, const MeshRegistry& registry, unsigned int input,
+                            const std::vector<DrawElementsIndirectCommand>& commandRecords) {
+    program = programs.program(programs.requestCompute(cullComputeShaderSource));
+    bindUniformBlock(program, "FrameData", kFrameDataBinding);
+    bindUniformBlock(program, "ObjectData", kObjectDataBinding);
+    instanceCountLocation = program.location("instanceCount");
+
+    instanceBuffer = input;
+    records = commandRecords;
+
+    std::vector<CullMesh> meshes(records.size());
+    std::vector<unsigned int> instanceMeshes;
+    for (size_t m = 0; m < records.size(); m++) {
+        const MeshRange& range = registry.mesh(static_cast<int>(m));
+        meshes[m] = CullMesh{ glm::vec4(range.bounds.center, range.bounds.radius), {}, 0, {} };
+        meshes[m].lodCount = static_cast<unsigned int>(std::min<size_t>(range.lods.size(), kMaxLods));
+        for (unsigned int level = 0; level < meshes[m].lodCount; level++) {
+            meshes[m].lodErrors[level] = range.lods[level].error;
+        }
+        instanceMeshes.resize(records[m].baseInstance + records[m].instanceCount, static_cast<unsigned int>(m));
+    }
+    instances = static_cast<unsigned int>(instanceMeshes.size());
+
+    std::vector<DrawElementsIndirectCommand> reset = resetCommands(registry);
+    commands = reset.size();
+
+    std::vector<unsigned int> lodState(instances, 0);
+    meshBuffer = createBuffer(GL_SHADER_STORAGE_BUFFER, meshes.size() * sizeof(CullMesh), meshes.data(), GL_STATIC_DRAW);
+    instanceMeshBuffer = createBuffer(GL_SHADER_STORAGE_BUFFER, instanceMeshes.size() * sizeof(unsigned int), instanceMeshes.data(), GL_STATIC_DRAW);
+    lodStateBuffer = createBuffer(GL_SHADER_STORAGE_BUFFER, lodState.size() * sizeof(unsigned int), lodState.data(), GL_DYNAMIC_COPY);
+    visibleBuffer = createBuffer(GL_SHADER_STORAGE_BUFFER, instances * kMaxLods * sizeof(InstanceData), nullptr, GL_DYNAMIC_COPY);
+    // Zero-count copy of the commands, copied over the live ones before each cull;
+    // rewritten by updateCommands() while meshes stream in
+    resetBuffer = createBuffer(GL_COPY_READ_BUFFER, reset.size() * sizeof(DrawElementsIndirectCommand), reset.data(), GL_DYNAMIC_DRAW);
+    indirectBuffer = createBuffer(GL_DRAW_INDIRECT_BUFFER, reset.size() * sizeof(DrawElementsIndirectCommand), reset.data(), GL_DYNAMIC_COPY);
+}
+
+// Level l of every mesh gets its own copy of the instance layout, so any split
+// of a mesh's instances across levels fits
+std::vector<DrawElementsIndirectCommand> InstanceCuller::resetCommands(const MeshRegistry& registry) const {
+    std::vector<DrawElementsIndirectCommand> reset;
+    for (size_t m = 0; m < records.size(); m++) {
+        unsigned int lodCount = static_cast<unsigned int>(std::min<size_t>(registry.mesh(static_cast<int>(m)).lods.size(), kMaxLods));
+        for (unsigned int level = 0; level < kMaxLods; level++) {
+            unsigned int baseInstance = level * instances + records[m].baseInstance;
+            reset.push_back(level < lodCount
+                ? registry.command(static_cast<int>(m), 0, baseInstance, level)
+                : DrawElementsIndirectCommand{ 0, 0, 0, 0, baseInstance });
+        }
+    }
+    return reset;
+}
+
+void InstanceCuller::updateCommands(const MeshRegistry& registry) const {
+    std::vector<DrawElementsIndirectCommand> reset = resetCommands(registry);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, resetBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, reset.size() * sizeof(DrawElementsIndirectCommand), reset.data());
+}
+
+void InstanceCuller::destroy() {
+    // The program belongs to the ProgramCache
+    program = ShaderProgram();
+    for (unsigned int* buffer : { &visibleBuffer, &indirectBuffer, &resetBuffer, &meshBuffer, &instanceMeshBuffer, &lodStateBuffer }) {
+        glDeleteBuffers(1, buffer);
+    }
+    *this = InstanceCuller();
+}
+
+void InstanceCuller::cull() const {
+    glBindBuffer(GL_COPY_READ_BUFFER, resetBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, indirectBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, commands * sizeof(DrawElementsIndirectCommand));
+
+    glUseProgram(program.id);
+    glUniform1ui(instanceCountLocation, instances);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibleBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, indirectBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, meshBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, instanceMeshBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, lodStateBuffer);
+    glDispatchCompute((instances + kCullGroupSize - 1) / kCullGroupSize, 1, 1);
+
+    // The draw reads the counts as indirect parameters and the instances as attributes
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
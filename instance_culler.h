@@ -0,0 +1,52 @@
+#pragma once
+
+#include "mesh_registry.h"
+#include "program_cache.h"
+
+#include <vector>
+
+// GPU frustum culling and LOD selection for the indirect path. Every frame a
+// compute pass tests each instance's bounding sphere against
+// FrameData.frustumPlanes, picks its level from FrameData.lodSelection, copies
+// the survivors into a compacted instance buffer and writes the counts straight
+// into the indirect command buffer, so nothing is read back. The buffer holds
+// kMaxLods commands per mesh (mesh-major); unused levels stay empty.
+// Needs a 4.3 context.
+class InstanceCuller {
+public:
+    // `commands` holds one level-0 record per registry mesh; instances
+    // [baseInstance, baseInstance + instanceCount) of `instanceBuffer` belong to it
+    void create(ProgramCache& programs, const MeshRegistry& registry, unsigned int instanceBuffer,
+                const std::vector<DrawElementsIndirectCommand>& commands);
+    void destroy();
+
+    // Re-reads the level ranges from the registry, e.g. after more of a mesh
+    // has streamed in
+    void updateCommands(const MeshRegistry& registry) const;
+
+    // Resets the counts and dispatches the cull. FrameData and ObjectData must be
+    // bound, since the shared model matrix comes from ObjectData.
+    void cull() const;
+
+    // Compacted instances: attach these to the registry VAO in place of the input
+    unsigned int visibleInstances() const { return visibleBuffer; }
+    // Bind as GL_DRAW_INDIRECT_BUFFER after cull()
+    unsigned int indirectCommands() const { return indirectBuffer; }
+    size_t commandCount() const { return commands; }
+
+private:
+    std::vector<DrawElementsIndirectCommand> resetCommands(const MeshRegistry& registry) const;
+
+    ShaderProgram program;
+    std::vector<DrawElementsIndirectCommand> records;
+    int instanceCountLocation = -1;
+    unsigned int instanceBuffer = 0;
+    unsigned int visibleBuffer = 0;
+    unsigned int indirectBuffer = 0;
+    unsigned int resetBuffer = 0;
+    unsigned int meshBuffer = 0;
+    unsigned int instanceMeshBuffer = 0;
+    unsigned int lodStateBuffer = 0;
+    unsigned int instances = 0;
+    size_t commands = 0;
+};
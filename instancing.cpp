@@ -0,0 +1,76 @@
+#include "instancing.h"
+#include "transform.h"
+
+#include <glad/glad.h>
+#include <cmath>
+#include <cstddef>
+
+// Evenly spread hues starting at red, so instance 0 keeps the original colour
+static glm::vec3 instanceColor(size_t index) {
+    float hue = std::fmod(static_cast<float>(index) * 0.618034f, 1.0f) * 6.0f;
+    float x = 1.0f - std::fabs(std::fmod(hue, 2.0f) - 1.0f);
+    switch (static_cast<int>(hue)) {
+    case 0: return glm::vec3(1.0f, x, 0.0f);
+    case 1: return glm::vec3(x, 1.0f, 0.0f);
+    case 2: return glm::vec3(0.0f, 1.0f, x);
+    case 3: return glm::vec3(0.0f, x, 1.0f);
+    case 4: return glm::vec3(x, 0.0f, 1.0f);
+    default: return glm::vec3(1.0f, 0.0f, x);
+    }
+}
+
+std::vector<InstanceData> buildInstanceField(size_t count, const Bounds& bounds, std::vector<ObjectPlacement>* placements) {
+    std::vector<InstanceData> instances(count);
+    size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    float radius = glm::length(bounds.max - bounds.min) * 0.5f;
+    float spacing = radius * 2.5f;
+    float scale = 1.0f / static_cast<float>(side);
+    float centre = (static_cast<float>(side) - 1.0f) * 0.5f;
+
+    for (size_t i = 0; i < count; i++) {
+        float x = (static_cast<float>(i % side) - centre) * spacing * scale;
+        float z = (static_cast<float>(i / side) - centre) * spacing * scale;
+        ObjectPlacement placement;
+        placement.position = glm::vec3(x, 0.0f, z);
+        placement.angleY = static_cast<float>(i) * 0.7f;
+        placement.scale = scale;
+        glm::mat4 model = placementMatrix(placement);
+        if (placements) {
+            placements->push_back(placement);
+        }
+
+        instances[i].model = model;
+        // Translation, rotation and uniform scale only
+        instances[i].normalMatrix = computeNormalMatrix(model, true);
+        instances[i].color = glm::vec4(instanceColor(i), 1.0f);
+    }
+    return instances;
+}
+
+void setupInstanceAttributes(unsigned int buffer, unsigned int firstInstance) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    const GLsizei stride = sizeof(InstanceData);
+    const size_t base = static_cast<size_t>(firstInstance) * stride;
+    for (unsigned int column = 0; column < 4; column++) {
+        unsigned int location = 3 + column;
+        size_t offset = base + offsetof(InstanceData, model) + column * sizeof(glm::vec4);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+    for (unsigned int column = 0; column < 3; column++) {
+        unsigned int location = 7 + column;
+        size_t offset = base + offsetof(InstanceData, normalMatrix) + column * sizeof(glm::vec3);
+        glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+    const size_t vectors[] = {
+        offsetof(InstanceData, color), offsetof(InstanceData, positionOffset), offsetof(InstanceData, positionScale) };
+    for (unsigned int i = 0; i < 3; i++) {
+        unsigned int location = 10 + i;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + vectors[i]));
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "batch_transform.h"
+#include "mesh.h"
+
+#include <vector>
+
+// Per-instance vertex attributes (divisor 1) at locations 3-12: model matrix,
+// normal matrix, colour and the dequantization of the mesh being instanced
+// (w of positionOffset flags octahedral normals). Carrying the mesh terms per
+// instance lets one indirect draw cover meshes with different bounds.
+// 148 bytes per instance.
+struct InstanceData {
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
+    glm::vec4 color;
+    glm::vec4 positionOffset = glm::vec4(0.0f);
+    glm::vec4 positionScale = glm::vec4(1.0f);
+};
+
+// Lays `count` copies of a mesh out on a square grid in the XZ plane. The field is
+// scaled to the footprint of a single mesh, so any count fits the default camera;
+// a count of one is the untransformed mesh in red. `placements`, when given,
+// receives the position, rotation and scale each model matrix was built from.
+std::vector<InstanceData> buildInstanceField(size_t count, const Bounds& bounds,
+                                             std::vector<ObjectPlacement>* placements = nullptr);
+
+// Describes the instance attributes for `buffer` in the currently bound VAO,
+// starting at instance `firstInstance`
+void setupInstanceAttributes(unsigned int buffer, unsigned int firstInstance = 0);
@@ -0,0 +1,40 @@
+#include "linear_arena.h"
+
+#include <algorithm>
+#include <new>
+
+void* LinearArena::allocate(size_t size, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!blocks.empty()) {
+        size_t offset = (head + alignment - 1) / alignment * alignment;
+        if (offset + size <= blocks.back().size) {
+            head = offset + size;
+            return blocks.back().data + offset;
+        }
+    }
+    // operator new aligns for any fundamental type, so a fresh block needs no padding
+    size_t blockSize = std::max(size, blockBytes);
+    Block block{ static_cast<unsigned char*>(::operator new(blockSize)), blockSize };
+    if (!blocks.empty() && size > blockBytes) {
+        // A large request gets a block of its own behind the current one,
+        // which keeps filling up
+        blocks.insert(blocks.end() - 1, block);
+    }
+    else {
+        blocks.push_back(block);
+        head = size;
+    }
+    reserved += blockSize;
+    peak = std::max(peak, reserved);
+    return block.data;
+}
+
+void LinearArena::release() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const Block& block : blocks) {
+        ::operator delete(block.data);
+    }
+    blocks.clear();
+    head = 0;
+    reserved = 0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Bump allocator for data that all dies at the same time, like the scratch
+// arrays of one OBJ parse. Memory comes from blocks of at least `blockSize`
+// bytes (larger requests get a block of their own) and is only given back all
+// at once by release() or destruction; deallocate() does nothing. Allocation
+// takes a lock so parse threads can share one arena, which is cheap as long as
+// containers are reserved up front rather than grown element by element.
+class LinearArena {
+public:
+    explicit LinearArena(size_t blockSize = 1 << 20) : blockBytes(blockSize) {}
+    ~LinearArena() { release(); }
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+    // Frees every block in one go; everything allocated so far is gone
+    void release();
+
+    // Bytes of blocks held now and the most ever held since construction
+    size_t reservedBytes() const { return reserved; }
+    size_t peakBytes() const { return peak; }
+
+private:
+    struct Block {
+        unsigned char* data;
+        size_t size;
+    };
+
+    std::mutex mutex;
+    std::vector<Block> blocks;
+    size_t blockBytes;
+    size_t head = 0;  // used bytes of blocks.back()
+    size_t reserved = 0;
+    size_t peak = 0;
+};
+
+// Standard allocator over a LinearArena, so std::vector and friends can keep
+// their scratch there. Growing a container leaves its old storage behind in
+// the arena until release().
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(LinearArena& arena) : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+private:
+    template <typename U> friend class ArenaAllocator;
+    LinearArena* arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
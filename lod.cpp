@@ -0,0 +1,33 @@
+#include "lod.h"
+
+#include <algorithm>
+
+float lodPixelScale(const glm::mat4& projection, float viewportHeight) {
+    return projection[1][1] * viewportHeight * 0.5f;
+}
+
+float lodErrorToPixels(const glm::vec3& eye, const glm::vec3& center, float radius, float worldScale, float pixelScale) {
+    float distance = glm::length(center - eye) - radius;
+    // Inside (or touching) the bounds: any error is too much
+    if (distance <= 1e-4f) {
+        return 1e30f;
+    }
+    return worldScale * pixelScale / distance;
+}
+
+unsigned int selectLod(const std::vector<MeshLod>& lods, float errorToPixels, float thresholdPixels, unsigned int current) {
+    if (thresholdPixels <= 0.0f || lods.size() < 2) {
+        return 0;
+    }
+    unsigned int target = 0;
+    for (unsigned int level = static_cast<unsigned int>(lods.size()) - 1; level > 0; level--) {
+        if (lods[level].error * errorToPixels <= thresholdPixels) {
+            target = level;
+            break;
+        }
+    }
+    while (target > current && lods[target].error * errorToPixels > thresholdPixels * kLodHysteresis) {
+        target--;
+    }
+    return target;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <vector>
+
+// A coarser level is only taken once its projected error is this fraction of
+// the threshold, so an object sitting at a switch distance does not pop back
+// and forth; going finer happens as soon as the threshold is exceeded
+const float kLodHysteresis = 0.75f;
+
+// Pixels covered by one world unit at distance 1 for a viewport `viewportHeight`
+// pixels tall: projection[1][1] is cot(fovy / 2)
+float lodPixelScale(const glm::mat4& projection, float viewportHeight);
+
+// Converts a world-space error on a sphere at `center` (already transformed,
+// radius in world units) into pixels. The nearest point of the sphere is used,
+// so a camera inside the bounds always asks for full detail.
+float lodErrorToPixels(const glm::vec3& eye, const glm::vec3& center, float radius, float worldScale, float pixelScale);
+
+// The coarsest level whose error stays within `thresholdPixels`, moving away
+// from `current` with hysteresis. A threshold of 0 always selects level 0.
+unsigned int selectLod(const std::vector<MeshLod>& lods, float errorToPixels, float thresholdPixels, unsigned int current);
@@ -2,323 +2,877 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
 #include <iostream>
-#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 #include <vector>
-#include <set>
-#include <sstream>
 
-// Vertex Shader (updated for lighting)
-const char* vertexShaderSource = R"glsl(
-#version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-
-uniform mat4 mvp;
-uniform mat4 model;
+#include "asset_loader.h"
+#include "batch_transform.h"
+#include "lod.h"
+#include "mesh_registry.h"
+#include "memory_report.h"
+#include "mesh_streamer.h"
+#include "clustered_lights.h"
+#include "instance_culler.h"
+#include "meshlet_culler.h"
+#include "shader_program.h"
+#include "shaders.h"
+#include "uniform_ring.h"
+#include "transform.h"
+#include "instancing.h"
+#include "options.h"
+#include "outline_pass.h"
+#include "perf_suite.h"
+#include "benchmark.h"
+#include "frame_readback.h"
+#include "profiler.h"
+#include "redraw_tracker.h"
+#include "program_cache.h"
+#include "render_queue.h"
+#include "shadow_cascades.h"
+#include "simulation.h"
+#include "thread_pool.h"
+#include "thumbnail_batch.h"
+
+// Camera keys currently held, for the update thread
+static unsigned int cameraKeys(GLFWwindow* window) {
+    unsigned int keys = 0;
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) keys |= kKeyRotateLeft;
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) keys |= kKeyRotateRight;
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) keys |= kKeyTiltUp;
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) keys |= kKeyTiltDown;
+    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) keys |= kKeyZoomIn;
+    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) keys |= kKeyZoomOut;
+    return keys;
+}
 
-out vec3 FragPos;
-out vec3 Normal;
+// Seconds the on-demand loop sleeps in glfwWaitEventsTimeout when nothing
+// changed; bounds how long a camera step published after the check waits
+static const double kIdleWaitSeconds = 0.1;
 
-void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    gl_Position = mvp * vec4(aPos, 1.0);
-}
-)glsl";
-
-// Fragment Shader (updated for lighting)
-const char* fragmentShaderSource = R"glsl(
-#version 330 core
-out vec4 FragColor;
-
-in vec3 FragPos;
-in vec3 Normal;
-
-uniform vec3 objectColor;
-uniform vec3 lightDir;
-uniform vec3 lightColor;
-
-void main() {
-    // Ambient
-    float ambientStrength = 0.1;
-    vec3 ambient = ambientStrength * lightColor;
-
-    // Diffuse
-    vec3 norm = normalize(Normal);
-    vec3 lightDirNorm = normalize(-lightDir);
-    float diff = max(dot(norm, lightDirNorm), 0.0);
-    vec3 diffuse = diff * lightColor;
-
-    // Combine
-    vec3 result = (ambient + diffuse) * objectColor;
-    FragColor = vec4(result, 1.0);
+// The window was uncovered or resized and its contents are lost
+static void windowRefresh(GLFWwindow* window) {
+    static_cast<RedrawTracker*>(glfwGetWindowUserPointer(window))->markDirty();
 }
-)glsl";
-
-// Outline Shader (unchanged)
-const char* outlineFragmentShader = R"glsl(
-#version 330 core
-out vec4 FragColor;
-void main() {
-    FragColor = vec4(0.0, 0.0, 0.0, 1.0);
-}
-)glsl";
-
-struct Mesh {
-    std::vector<float> vertices;
-    std::vector<float> normals;
-    std::vector<unsigned int> indices;
-    std::vector<unsigned int> edgeIndices;
-};
-
-Mesh loadOBJ(const char* path) {
-    Mesh mesh;
-    std::ifstream file(path);
-    std::string line;
-    std::vector<glm::vec3> tempVertices;
-    std::vector<glm::vec3> tempNormals;
-
-    while (std::getline(file, line)) {
-        if (line.substr(0, 2) == "v ") {
-            std::istringstream ss(line.substr(2));
-            glm::vec3 vertex;
-            ss >> vertex.x >> vertex.y >> vertex.z;
-            tempVertices.push_back(vertex);
-        }
-        else if (line.substr(0, 3) == "vn ") {
-            std::istringstream ss(line.substr(3));
-            glm::vec3 normal;
-            ss >> normal.x >> normal.y >> normal.z;
-            tempNormals.push_back(normal);
-        }
-        else if (line.substr(0, 2) == "f ") {
-            std::istringstream ss(line.substr(2));
-            std::string token;
-            std::vector<unsigned int> faceVerts, faceNormals;
-
-            while (ss >> token) {
-                size_t pos1 = token.find('/');
-                size_t pos2 = token.find('/', pos1 + 1);
-                unsigned int v = std::stoul(token.substr(0, pos1)) - 1;
-                unsigned int n = std::stoul(token.substr(pos2 + 1)) - 1;
-                faceVerts.push_back(v);
-                faceNormals.push_back(n);
-            }
 
-            // Triangulate face
-            for (size_t i = 1; i < faceVerts.size() - 1; i++) {
-                mesh.indices.push_back(faceVerts[0]);
-                mesh.indices.push_back(faceVerts[i]);
-                mesh.indices.push_back(faceVerts[i + 1]);
-
-                // Add normals
-                for (int j = 0; j < 3; j++) {
-                    glm::vec3 normal = tempNormals[faceNormals[j]];
-                    mesh.normals.push_back(normal.x);
-                    mesh.normals.push_back(normal.y);
-                    mesh.normals.push_back(normal.z);
-                }
-            }
+// Prefers a 4.x core context for the newer buffer and draw paths, falling back
+// to 3.3 where the driver (or macOS) offers nothing newer
+static GLFWwindow* createWindow(int width, int height, const char* title) {
+    const int versions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 3 }, { 3, 3 } };
+    for (const int* version : versions) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        GLFWwindow* window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+        if (window) {
+            return window;
         }
     }
-
-    // Add vertices to mesh
-    for (auto& vertex : tempVertices) {
-        mesh.vertices.push_back(vertex.x);
-        mesh.vertices.push_back(vertex.y);
-        mesh.vertices.push_back(vertex.z);
-    }
-
-    return mesh;
+    return nullptr;
 }
 
-unsigned int compileShader(unsigned int type, const char* source) {
-    unsigned int id = glCreateShader(type);
-    glShaderSource(id, 1, &source, nullptr);
-    glCompileShader(id);
-
-    int success;
-    glGetShaderiv(id, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(id, 512, nullptr, infoLog);
-        std::cerr << "Shader error:\n" << infoLog << std::endl;
+int main(int argc, char* argv[]) {
+    // --bench-load [path] [iterations]: time the OBJ parser without opening a window
+    if (argc > 1 && std::strcmp(argv[1], "--bench-load") == 0) {
+        const char* path = argc > 2 ? argv[2] : "teapot.obj";
+        int iterations = argc > 3 ? std::atoi(argv[3]) : 10;
+        return runLoadBenchmark(path, iterations);
     }
-    return id;
-}
-
-unsigned int createShaderProgram(const char* vertexSource, const char* fragmentSource) {
-    unsigned int program = glCreateProgram();
-    unsigned int vs = compileShader(GL_VERTEX_SHADER, vertexSource);
-    unsigned int fs = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
-
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
-    glLinkProgram(program);
-
-    int success;
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(program, 512, nullptr, infoLog);
-        std::cerr << "Program linking error:\n" << infoLog << std::endl;
+    // --bench-transform [objects] [iterations]: batched SIMD transforms against glm
+    if (argc > 1 && std::strcmp(argv[1], "--bench-transform") == 0) {
+        size_t count = argc > 2 ? static_cast<size_t>(std::atol(argv[2])) : 100000;
+        int iterations = argc > 3 ? std::atoi(argv[3]) : 20;
+        return runTransformBenchmark(count, iterations);
+    }
+    // --bench-suite [out.json] [iterations]: every hot-path timing in one JSON file
+    if (argc > 1 && std::strcmp(argv[1], "--bench-suite") == 0) {
+        std::string out = argc > 2 ? argv[2] : "";
+        int iterations = argc > 3 ? std::atoi(argv[3]) : 10;
+        return runPerfSuite(argv[0], out, iterations);
+    }
+    // --bench-compare baseline.json current.json [percent]: fails on a regression past the threshold
+    if (argc > 1 && std::strcmp(argv[1], "--bench-compare") == 0) {
+        if (argc < 4) {
+            std::cerr << "Usage: --bench-compare baseline.json current.json [percent]" << std::endl;
+            return -1;
+        }
+        double threshold = argc > 4 ? std::atof(argv[4]) : 10.0;
+        return runPerfCompare(argv[2], argv[3], threshold);
     }
 
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-
-    return program;
-}
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return -1;
+    }
 
-int main() {
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
         return -1;
     }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Red Teapot with Lighting", nullptr, nullptr);
+    // --benchmark and --thumbnails render offscreen at their own resolution;
+    // the window only provides the context
+    if (options.benchmark || !options.thumbnailOut.empty()) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+    GLFWwindow* window = createWindow(800, 600, "Red Teapot with Lighting");
     if (!window) {
         std::cerr << "Failed to create window" << std::endl;
         glfwTerminate();
         return -1;
     }
     glfwMakeContextCurrent(window);
+    if (options.benchmark) {
+        glfwSwapInterval(0);
+    }
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         std::cerr << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
 
-    // Load teapot data
-    Mesh mesh = loadOBJ("teapot.obj");
+    if (options.drawMode == DrawMode::Indirect && !GLAD_GL_VERSION_4_3) {
+        std::cerr << "Indirect draws need OpenGL 4.3, using one instanced draw per mesh" << std::endl;
+        options.drawMode = DrawMode::Instanced;
+    }
+    if (options.lightCount && !GLAD_GL_VERSION_4_3) {
+        std::cerr << "Clustered lights need OpenGL 4.3, using the directional light only" << std::endl;
+        options.lightCount = 0;
+    }
+    if (options.meshlets && options.drawMode != DrawMode::Indirect) {
+        std::cerr << "Meshlet culling needs indirect draws, drawing whole meshes" << std::endl;
+        options.meshlets = false;
+    }
 
-    // Create and bind buffers
-    unsigned int VAO, VBO, EBO, NBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-    glGenBuffers(1, &NBO);
+    if (!options.thumbnailOut.empty()) {
+        int exitCode = runThumbnailBatch(options);
+        glfwTerminate();
+        return exitCode;
+    }
 
-    glBindVertexArray(VAO);
+    // Every program starts compiling now, on driver threads where supported, and
+    // is only waited for when it is first used after loading
+    ProgramCache programs;
+    programs.create(options.useCache ? options.shaderCache : std::string());
+    const std::string shadingSource = shadingFragmentShader(options.lightCount != 0, options.shadows);
+    const int mainProgram = programs.request(vertexShaderSource, shadingSource.c_str());
+    const int instancedProgram = programs.request(instancedVertexShaderSource, shadingSource.c_str());
+    // Shadow casters draw with the instanced depth program too
+    const bool depthPrograms = options.depthPrepass || options.shadows;
+    int depthProgram = -1, depthInstancedProgram = -1;
+    if (depthPrograms) {
+        depthProgram = programs.request(depthVertexShaderSource, depthFragmentShaderSource);
+        depthInstancedProgram = programs.request(depthInstancedVertexShaderSource, depthFragmentShaderSource);
+    }
+    if (options.outline) {
+        programs.request(fullscreenVertexShaderSource, outlineFragmentShader);
+    }
+    if (options.lightCount) {
+        programs.requestCompute(clusterCullComputeShaderSource);
+    }
+    if (options.meshlets) {
+        programs.requestCompute(meshletCullComputeShaderSource);
+    }
+    else if (options.drawMode == DrawMode::Indirect && options.gpuCull) {
+        programs.requestCompute(cullComputeShaderSource);
+    }
 
-    // Vertex buffer
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    // Meshes are parsed on a worker pool while the window keeps presenting frames
+    AssetLoader loader;
+    loader.start(options.meshPaths, options);
+    if (options.syncLoad) {
+        loader.wait();
+    }
+    while (!loader.done() && !glfwWindowShouldClose(window)) {
+        std::cout << loader.takeReport() << std::flush;
+        std::string title = "Red Teapot with Lighting - loading " + std::to_string(loader.completed()) + "/" +
+            std::to_string(loader.requested());
+        glfwSetWindowTitle(window, title.c_str());
+        glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glfwSwapBuffers(window);
+        // Nothing moves until the meshes are in, so there is no point spinning
+        glfwWaitEventsTimeout(1.0 / 30.0);
+    }
+    loader.wait();
+    std::cout << loader.takeReport() << std::flush;
+
+    // Every mesh is sub-allocated into one shared vertex and index buffer. The
+    // data then streams in a budgeted slice per frame, with a box over each
+    // mesh's bounds until its coarsest level arrives. Meshlet culling reads the
+    // full index ranges from the first frame, so that mode uploads up front.
+    bool streaming = !options.syncLoad && !options.meshlets;
+    MeshRegistry registry;
+    registry.create(options.layout);
+    if (depthPrograms) {
+        registry.enablePositionStream();
+    }
+    MeshStreamer streamer;
+    streamer.create(static_cast<size_t>(options.uploadBudget) * 1024);
+    // Every part of an OBJ (one per material) is a registry mesh of its own
+    std::vector<MaterialUniforms> materials(1, MaterialUniforms{ glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) });
+    std::vector<size_t> meshSources;
+    std::vector<unsigned int> meshMaterials;
+    size_t sourceCount = loader.requested();
+    MemoryReport memoryReport;
+    for (size_t i = 0; i < sourceCount; i++) {
+        const LoadedMesh& loaded = loader.mesh(i);
+        size_t hostBytes = 0, deviceBytes = 0;
+        for (const std::unique_ptr<LoadedPart>& part : loaded.parts) {
+            int id = streaming ? streamer.add(registry, part->view) : registry.add(part->view);
+            meshSources.push_back(i);
+            meshMaterials.push_back(part->material ? addMaterial(materials, *part->material) : 0);
+            const MeshView& view = part->view;
+            hostBytes += view.vertexCount * view.stride + view.indexCount * sizeof(unsigned int) + view.meshletCount * sizeof(Meshlet);
+            deviceBytes += id >= 0 ? registry.meshBytes(id) : 0;
+        }
+        memoryReport.addAsset(loaded.path, loaded.scratchBytes, hostBytes, deviceBytes);
+    }
+    size_t meshCount = registry.meshCount();
+    if (streaming) {
+        for (size_t m = 0; m < meshCount; m++) {
+            addPlaceholder(registry, static_cast<int>(m));
+        }
+    }
+    else {
+        loader.clear();
+        memoryReport.markUploaded();
+    }
 
-    // Normal buffer
-    glBindBuffer(GL_ARRAY_BUFFER, NBO);
-    glBufferData(GL_ARRAY_BUFFER, mesh.normals.size() * sizeof(float), mesh.normals.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
+    Bounds sceneBounds = registry.mesh(0).bounds;
+    for (size_t m = 1; m < meshCount; m++) {
+        sceneBounds.min = glm::min(sceneBounds.min, registry.mesh(m).bounds.min);
+        sceneBounds.max = glm::max(sceneBounds.max, registry.mesh(m).bounds.max);
+    }
 
-    // Element buffer
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+    // Field of objects, instanceCount per OBJ, with cell i showing file
+    // i % sourceCount; all parts of a file share its cells. Instances are
+    // grouped by mesh so each mesh draws one contiguous run; a single teapot is
+    // the original untransformed one.
+    std::vector<ObjectPlacement> placements;
+    std::vector<InstanceData> field = buildInstanceField(options.instanceCount * sourceCount, sceneBounds, &placements);
+    std::vector<InstanceData> instances;
+    TransformInputs objectTransforms;
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<int> instanceMeshes;
+    instances.reserve(field.size());
+    for (size_t m = 0; m < meshCount; m++) {
+        const MeshRange& range = registry.mesh(static_cast<int>(m));
+        unsigned int firstInstance = static_cast<unsigned int>(instances.size());
+        for (size_t i = meshSources[m]; i < field.size(); i += sourceCount) {
+            InstanceData instance = field[i];
+            instance.positionOffset = glm::vec4(range.positionOffset, options.layout != VertexLayout::Float ? 1.0f : 0.0f);
+            instance.positionScale = glm::vec4(range.positionScale, static_cast<float>(meshMaterials[m]));
+            instances.push_back(instance);
+            instanceMeshes.push_back(static_cast<int>(m));
+            objectTransforms.add(placements[i], range.bounds);
+        }
+        commands.push_back(registry.command(static_cast<int>(m), static_cast<unsigned int>(instances.size()) - firstInstance, firstInstance));
+    }
+
+    // The instance buffer is part of the registry VAO and is ignored by the
+    // non-instanced shader
+    unsigned int instanceBuffer;
+    glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(InstanceData), instances.data(), GL_STATIC_DRAW);
+    registry.attachInstances(instanceBuffer);
+    if (options.shadows) {
+        registry.attachCasterInstances(instanceBuffer);
+    }
+
+    // Bounds every caster however the shared rotation turns the objects, each
+    // of which spins about its own placement
+    glm::vec4 sceneSphere(0.0f);
+    for (size_t i = 0; i < instances.size(); i++) {
+        const Bounds& bounds = registry.mesh(instanceMeshes[i]).bounds;
+        float scale = glm::length(glm::vec3(instances[i].model[0]));
+        float reach = glm::length(glm::vec3(instances[i].model[3])) + (glm::length(bounds.center) + bounds.radius) * scale;
+        sceneSphere.w = std::max(sceneSphere.w, reach);
+    }
+
+    // One indirect record per mesh. With culling the compute pass rewrites the
+    // counts every frame and the VAO reads the compacted instances instead;
+    // without it the instance layout never changes, so this buffer only changes
+    // as meshes stream in.
+    InstanceCuller culler;
+    MeshletCuller meshletCuller;
+    unsigned int indirectBuffer = 0;
+    if (options.meshlets) {
+        // Meshlet draws index the full instance buffer, which stays attached
+        meshletCuller.create(programs, registry, instanceBuffer, commands);
+    }
+    else if (options.drawMode == DrawMode::Indirect && options.gpuCull) {
+        culler.create(programs, registry, instanceBuffer, commands);
+        registry.attachInstances(culler.visibleInstances());
+        indirectBuffer = culler.indirectCommands();
+    }
+    else if (options.drawMode == DrawMode::Indirect) {
+        glGenBuffers(1, &indirectBuffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(),
+                     streaming ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+    }
 
     // Create shaders
-    unsigned int mainShader = createShaderProgram(vertexShaderSource, fragmentShaderSource);
-    unsigned int outlineShader = createShaderProgram(vertexShaderSource, outlineFragmentShader);
+    ShaderProgram mainShader = programs.program(mainProgram);
+    ShaderProgram instancedShader = programs.program(instancedProgram);
+    ShaderProgram depthShader, depthInstancedShader;
+    if (depthPrograms) {
+        depthShader = programs.program(depthProgram);
+        depthInstancedShader = programs.program(depthInstancedProgram);
+        for (const ShaderProgram* program : { &depthShader, &depthInstancedShader }) {
+            bindUniformBlock(*program, "FrameData", kFrameDataBinding);
+            bindUniformBlock(*program, "ObjectData", kObjectDataBinding);
+        }
+    }
+    std::cout << programs.report() << std::endl;
+    for (const ShaderProgram* program : { &mainShader, &instancedShader }) {
+        bindUniformBlock(*program, "FrameData", kFrameDataBinding);
+        bindUniformBlock(*program, "ObjectData", kObjectDataBinding);
+        bindUniformBlock(*program, "MaterialData", kMaterialDataBinding);
+        bindUniformBlock(*program, "ClusterData", kClusterDataBinding);
+        bindUniformBlock(*program, "ShadowData", kShadowDataBinding);
+        if (options.shadows) {
+            glUseProgram(program->id);
+            glUniform1i(program->location("shadowMap"), kShadowTextureUnit);
+        }
+    }
+    glUseProgram(0);
+
+    // Sized for the whole block, which the shaders declare in full
+    unsigned int materialBuffer;
+    glGenBuffers(1, &materialBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, materialBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, kMaxMaterials * sizeof(MaterialUniforms), nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, materials.size() * sizeof(MaterialUniforms), materials.data());
+    glBindBufferBase(GL_UNIFORM_BUFFER, kMaterialDataBinding, materialBuffer);
+
+    // Frame and per-object uniforms are pushed into a triple-buffered ring,
+    // sized for one ObjectData per teapot when each is drawn separately, plus a
+    // FrameData per shadow cascade. 512 bytes is each block rounded up to a
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT of 256, which the ring does not check;
+    // with a larger one the ring grows after the first frame.
+    UniformRing uniformRing;
+    uniformRing.create((instances.size() + 1) * 512 + (kMaxShadowCascades + 1) * 512);
 
     glEnable(GL_DEPTH_TEST);
+    // Cone culling drops meshlets that only have back faces; those must not be
+    // visible for it to match drawing every meshlet
+    if (options.meshlets) {
+        glEnable(GL_CULL_FACE);
+    }
 
     // Lighting setup
     glm::vec3 lightDir(-0.2f, -1.0f, -0.3f); // Directional light
     glm::vec3 lightColor(1.0f, 1.0f, 1.0f);  // White light
     glm::vec3 objectColor(1.0f, 0.0f, 0.0f); // Blue teapot
 
-    // Rotation and zoom variables
-    float angleY = 0.0f;
-    float angleZ = 0.0f;
-    float rotationSpeed = 2.0f;
-    float zoomSpeed = 10.0f;
-    float cameraDistance = 5.196f; // Initial distance (sqrt(3+3+3))
-    glm::vec3 cameraDir = glm::normalize(glm::vec3(1.0f)); // Original direction (3,3,3) normalized
-    float lastFrameTime = 0.0f;
+    // The CPU draw paths transform every object each frame, batched and split
+    // across cores; indirect mode does it on the GPU
+    ThreadPool transformPool;
+    TransformOutputs objectOutputs;
+    objectOutputs.resize(instances.size());
+
+    // Frame rate in the title bar, refreshed once a second
+    double fpsWindowStart = glfwGetTime();
+    unsigned int fpsFrames = 0;
+    std::vector<size_t> objectOffsets;
+    // Whether the instanced paths' shared ObjectData fit in the ring this frame
+    bool sharedObjectBound = false;
+    // CPU draws are submitted sorted by program, material and depth
+    RenderQueue renderQueue;
+    std::vector<float> nearestDistance(meshCount);
+
+    // Current level per object (single draws) and per mesh (instanced draws),
+    // kept across frames for the LOD hysteresis
+    std::vector<unsigned int> instanceLods(instances.size(), 0);
+    std::vector<unsigned int> meshLods(meshCount, 0);
+    std::vector<float> nearestError(meshCount);
+
+    OutlinePass outline;
+    if (options.outline) {
+        outline.create(programs, kNearPlane, kFarPlane);
+    }
+
+    // Frames for thin clients leave through a ring of pixel buffers; the sink
+    // thread writes them out
+    FrameReadback readback;
+    if (!options.readbackOut.empty()) {
+        FrameSink sink = openPpmStreamSink(options.readbackOut);
+        if (!sink) {
+            return -1;
+        }
+        readback.create(options.readbackFrames, std::move(sink));
+    }
 
-    while (!glfwWindowShouldClose(window)) {
-        float currentFrame = glfwGetTime();
-        float deltaTime = currentFrame - lastFrameTime;
-        lastFrameTime = currentFrame;
+    // Point and spot lights over the field, binned into froxels every frame
+    ClusteredLights clusteredLights;
+    if (options.lightCount) {
+        clusteredLights.create(programs, buildLightField(options.lightCount, sceneBounds));
+    }
+    ShadowCascades shadows;
+    if (options.shadows) {
+        shadows.create(options.shadowCascades, options.shadowResolution);
+    }
 
+    // Issues the frame's draws. With the depth pre-pass this runs twice, first
+    // over the position-only stream with the depth programs, then to shade.
+    auto submitDraws = [&](bool depthOnly) {
+        if (depthOnly) {
+            registry.bindPositions();
+        }
+        else {
+            registry.bind();
+        }
+        if (options.drawMode == DrawMode::Single) {
+            unsigned int boundProgram = 0;
+            for (const RenderQueue::Item& item : renderQueue.items()) {
+                unsigned int program = depthOnly ? depthShader.id : sortKeyProgram(item.key);
+                if (program != boundProgram) {
+                    boundProgram = program;
+                    glUseProgram(program);
+                }
+                if (objectOffsets[item.draw] == UniformRing::kFull) continue;
+                uniformRing.bindRange(kObjectDataBinding, objectOffsets[item.draw], sizeof(ObjectUniforms));
+                registry.draw(instanceMeshes[item.draw], instanceLods[item.draw]);
+            }
+            return;
+        }
+        if (!sharedObjectBound) {
+            return;
+        }
+        glUseProgram(depthOnly ? depthInstancedShader.id : instancedShader.id);
+        if (options.meshlets) {
+            meshletCuller.draw(registry);
+        }
+        else if (options.drawMode == DrawMode::Indirect) {
+            // The whole scene in one call
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+            registry.drawIndirect(options.gpuCull ? culler.commandCount() : commands.size());
+        }
+        else {
+            for (const RenderQueue::Item& item : renderQueue.items()) {
+                int m = static_cast<int>(item.draw);
+                registry.drawInstanced(m, commands[m].instanceCount, commands[m].baseInstance, meshLods[m]);
+            }
+        }
+    };
+
+    // Stages run in this order
+    FrameProfiler profiler;
+    const int uploadStage = profiler.addStage("upload");
+    const int clearStage = profiler.addStage("clear");
+    const int uniformStage = profiler.addStage("uniforms");
+    const int cullStage = profiler.addStage("cull");
+    const int lightStage = profiler.addStage("lights");
+    const int shadowStage = profiler.addStage("shadows");
+    const int prepassStage = profiler.addStage("prepass");
+    const int drawStage = profiler.addStage("draw");
+    const int outlineStage = profiler.addStage("outline");
+    const int readbackStage = profiler.addStage("readback");
+    const int swapStage = profiler.addStage("swap");
+    // Samples that pass the depth test: the shade counter is the overdraw the
+    // fragment shader pays for, which the pre-pass brings down to one per pixel
+    const int prepassSamples = profiler.addCounter("prepass");
+    const int shadeSamples = profiler.addCounter("shade");
+    if (options.profile) {
+        profiler.create(!options.profileCsv.empty() || !options.profileTrace.empty());
+    }
+
+    int renderWidth = options.benchmark ? static_cast<int>(options.benchmarkWidth) : 800;
+    int renderHeight = options.benchmark ? static_cast<int>(options.benchmarkHeight) : 600;
+    FrameBenchmark benchmark;
+    if (options.benchmark && !benchmark.create(renderWidth, renderHeight, options.benchmarkFrames, kBenchmarkWarmupFrames)) {
+        return -1;
+    }
+
+    // Camera movement runs on its own fixed-rate thread; the benchmark steps
+    // the camera per frame instead, so every run renders the same images
+    const float aspect = static_cast<float>(renderWidth) / renderHeight;
+    UpdateThread simulation;
+    if (!options.benchmark) {
+        simulation.start(CameraState(), aspect, options.updateRate);
+    }
+
+    // On demand, a pass with no held keys, nothing streaming and the same
+    // camera, lights and framebuffer as the last drawn frame waits for events
+    // instead of drawing the same image again
+    RedrawTracker redraw;
+    unsigned int heldKeys = 0;
+    bool idleTitle = false;
+    if (options.onDemand) {
+        glfwSetWindowUserPointer(window, &redraw);
+        glfwSetWindowRefreshCallback(window, windowRefresh);
+    }
+
+    while (!glfwWindowShouldClose(window) && !(options.benchmark && benchmark.done())) {
         // Input handling
         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
             glfwSetWindowShouldClose(window, true);
 
-        // Rotation controls
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-            angleY += rotationSpeed * deltaTime;
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-            angleY -= rotationSpeed * deltaTime;
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-            angleZ += rotationSpeed * deltaTime;
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-            angleZ -= rotationSpeed * deltaTime;
-
-        // Zoom controls
-        if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
-            cameraDistance -= zoomSpeed * deltaTime;
-        if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
-            cameraDistance += zoomSpeed * deltaTime;
-
-        // Clamp camera distance
-        cameraDistance = glm::clamp(cameraDistance, 1.5f, 40.0f);
+        if (options.onDemand && !heldKeys && !streaming) {
+            CameraState latest = simulation.latest();
+            SceneState scene{ latest.view, latest.projection, latest.model, lightDir, lightColor };
+            glfwGetFramebufferSize(window, &scene.width, &scene.height);
+            if (!redraw.needsRedraw(scene)) {
+                if (!idleTitle) {
+                    glfwSetWindowTitle(window, ("Red Teapot with Lighting - " + std::to_string(instances.size()) + " objects, idle").c_str());
+                    idleTitle = true;
+                }
+                redraw.waited();
+                glfwWaitEventsTimeout(kIdleWaitSeconds);
+                heldKeys = cameraKeys(window);
+                simulation.setInput(heldKeys);
+                // The fps window restarts with the next drawn frame
+                fpsWindowStart = glfwGetTime();
+                fpsFrames = 0;
+                continue;
+            }
+        }
 
-        glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        profiler.beginFrame();
+        if (options.benchmark) {
+            benchmark.beginFrame();
+        }
+
+        // The benchmark ignores input and replays the same path every run
+        CameraState camera;
+        if (options.benchmark) {
+            benchmarkCamera(benchmark.frameIndex(), options.benchmarkFrames + kBenchmarkWarmupFrames,
+                            camera.angleY, camera.angleZ, camera.cameraDistance);
+            buildCameraMatrices(camera, aspect);
+        }
+        else {
+            camera = simulation.latest();
+        }
+        const glm::vec3& eye = camera.eye;
+        const glm::mat4& projection = camera.projection;
+        const glm::mat4& view = camera.view;
+        const glm::mat4& model = camera.model;
+
+        int framebufferWidth = renderWidth, framebufferHeight = renderHeight;
+        if (!options.benchmark) {
+            glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        }
+        // The benchmark reads its own target; otherwise the frame is drawn
+        // offscreen and copied to the window after the readback starts
+        bool readFrame = !options.readbackOut.empty() && framebufferWidth > 0 && framebufferHeight > 0;
+        unsigned int sceneFramebuffer = options.benchmark ? benchmark.framebuffer() : 0;
+        if (readFrame && !options.benchmark) {
+            readback.bindTarget(framebufferWidth, framebufferHeight);
+            sceneFramebuffer = readback.framebuffer();
+        }
+
+        // With outlines the scene goes to the outline pass's target first
+        profiler.beginStage(clearStage);
+        if (options.outline) {
+            outline.begin(framebufferWidth, framebufferHeight, glm::vec4(0.2f, 0.2f, 0.2f, 1.0f));
+        }
+        else {
+            glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
+        profiler.endStage(clearStage);
+
+        // Indirect commands baked into buffers are refreshed when a mesh gains a
+        // level; the CPU draw paths ask the registry every frame anyway
+        profiler.beginStage(uploadStage);
+        if (streaming && streamer.update(registry)) {
+            shadows.invalidate();
+            if (options.drawMode == DrawMode::Indirect && options.gpuCull) {
+                culler.updateCommands(registry);
+            }
+            else if (options.drawMode == DrawMode::Indirect) {
+                for (size_t m = 0; m < meshCount; m++) {
+                    commands[m] = registry.command(static_cast<int>(m), commands[m].instanceCount, commands[m].baseInstance);
+                }
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+                glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data());
+            }
+        }
+        if (streaming && streamer.idle()) {
+            loader.clear();
+            memoryReport.markUploaded();
+            streaming = false;
+        }
+        profiler.endStage(uploadStage);
+
+        profiler.beginStage(uniformStage);
+        uniformRing.beginFrame();
+
+        FrameUniforms frame;
+        frame.view = view;
+        frame.projection = projection;
+        frame.viewProjection = projection * view;
+        frame.lightDir = glm::vec4(lightDir, 0.0f);
+        frame.lightColor = glm::vec4(lightColor, 1.0f);
+        frame.cameraPos = glm::vec4(eye, 1.0f);
+        extractFrustumPlanes(frame.viewProjection, frame.frustumPlanes);
+        // Errors are measured in the pixels actually drawn, so a resized or
+        // HiDPI window keeps the same detail on screen
+        float pixelScale = lodPixelScale(projection, static_cast<float>(framebufferHeight));
+        frame.lodSelection = glm::vec4(pixelScale, options.lodThreshold, kLodHysteresis, 0.0f);
+        // The first push of the frame, so it always fits
+        size_t frameOffset = uniformRing.push(&frame, sizeof(frame));
+        uniformRing.bindRange(kFrameDataBinding, frameOffset, sizeof(frame));
+
+        glm::mat3 normalMatrix = computeNormalMatrix(model, true);
+        if (options.drawMode != DrawMode::Indirect) {
+            transformPool.parallelFor(instances.size(), kTransformBatchGrain, [&](size_t begin, size_t end) {
+                transformBatch(objectTransforms, model, frame.viewProjection, objectOutputs, begin, end);
+            });
+        }
+
+        if (options.drawMode == DrawMode::Single) {
+            // One draw per object; the single-object case is the original teapot
+            objectOffsets.clear();
+            renderQueue.clear();
+            for (size_t i = 0; i < instances.size(); i++) {
+                const InstanceData& instance = instances[i];
+                ObjectUniforms object;
+                object.model = objectOutputs.world[i];
+                object.mvp = objectOutputs.mvp[i];
+                object.normalMatrix = glm::mat4(glm::mat3(object.model));
+                object.objectColor = field.size() == 1 ? glm::vec4(objectColor, 1.0f) : instance.color;
+                object.positionOffset = instance.positionOffset;
+                object.positionScale = instance.positionScale;
+                objectOffsets.push_back(uniformRing.push(&object, sizeof(object)));
+
+                const MeshRange& range = registry.mesh(instanceMeshes[i]);
+                float worldScale = glm::length(glm::vec3(object.model[0]));
+                glm::vec3 center(objectOutputs.sphereX[i], objectOutputs.sphereY[i], objectOutputs.sphereZ[i]);
+                float errorToPixels = lodErrorToPixels(eye, center, objectOutputs.sphereRadius[i], worldScale, pixelScale);
+                instanceLods[i] = selectLod(range.lods, errorToPixels, options.lodThreshold, instanceLods[i]);
+                renderQueue.push(makeSortKey(mainShader.id, meshMaterials[instanceMeshes[i]], glm::length(center - eye), kFarPlane),
+                                 static_cast<unsigned int>(i));
+            }
+            uniformRing.flush();
+            renderQueue.sort();
+            profiler.endStage(uniformStage);
+        }
+        else {
+            // The shared rotation; everything else comes from the instance stream
+            ObjectUniforms object;
+            object.mvp = frame.viewProjection * model;
+            object.model = model;
+            object.normalMatrix = glm::mat4(normalMatrix);
+            object.objectColor = glm::vec4(objectColor, 1.0f);
+            sharedObjectBound = uniformRing.pushAndBind(kObjectDataBinding, object);
+            uniformRing.flush();
+
+            if (!options.meshlets && options.drawMode != DrawMode::Indirect) {
+                // One level per mesh, fine enough for its nearest instance, and
+                // the meshes drawn in sorted order by that instance's distance
+                std::fill(nearestError.begin(), nearestError.end(), 0.0f);
+                std::fill(nearestDistance.begin(), nearestDistance.end(), kFarPlane);
+                for (size_t i = 0; i < instances.size(); i++) {
+                    float worldScale = glm::length(glm::vec3(objectOutputs.world[i][0]));
+                    glm::vec3 center(objectOutputs.sphereX[i], objectOutputs.sphereY[i], objectOutputs.sphereZ[i]);
+                    float errorToPixels = lodErrorToPixels(eye, center, objectOutputs.sphereRadius[i], worldScale, pixelScale);
+                    nearestError[instanceMeshes[i]] = std::max(nearestError[instanceMeshes[i]], errorToPixels);
+                    nearestDistance[instanceMeshes[i]] = std::min(nearestDistance[instanceMeshes[i]], glm::length(center - eye));
+                }
+                renderQueue.clear();
+                for (size_t m = 0; m < meshCount; m++) {
+                    meshLods[m] = selectLod(registry.mesh(static_cast<int>(m)).lods, nearestError[m], options.lodThreshold, meshLods[m]);
+                    renderQueue.push(makeSortKey(instancedShader.id, meshMaterials[m], nearestDistance[m], kFarPlane), static_cast<unsigned int>(m));
+                }
+                renderQueue.sort();
+            }
+            profiler.endStage(uniformStage);
+
+            profiler.beginStage(cullStage);
+            if (options.meshlets) {
+                meshletCuller.cull();
+            }
+            else if (options.drawMode == DrawMode::Indirect && options.gpuCull) {
+                culler.cull();
+            }
+            profiler.endStage(cullStage);
+        }
 
-        // Calculate camera position
-        glm::vec3 eye = cameraDir * cameraDistance;
-
-        // Create transformation matrices
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
-        glm::mat4 view = glm::lookAt(
-            eye,
-            glm::vec3(0.0f, 0.0f, 0.0f),
-            glm::vec3(0.0f, 1.0f, 0.0f)
-        );
-
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::rotate(model, angleY, glm::vec3(0.0f, 1.0f, 0.0f)); // Y-axis
-        model = glm::rotate(model, angleZ, glm::vec3(0.0f, 0.0f, 1.0f)); // Z-axis
-
-        glm::mat4 mvp = projection * view * model;
-
-        // Draw main teapot
-        glUseProgram(mainShader);
-        glUniformMatrix4fv(glGetUniformLocation(mainShader, "mvp"), 1, GL_FALSE, glm::value_ptr(mvp));
-        glUniformMatrix4fv(glGetUniformLocation(mainShader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniform3fv(glGetUniformLocation(mainShader, "objectColor"), 1, &objectColor[0]);
-        glUniform3fv(glGetUniformLocation(mainShader, "lightDir"), 1, &lightDir[0]);
-        glUniform3fv(glGetUniformLocation(mainShader, "lightColor"), 1, &lightColor[0]);
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, 0);
-
-        // Draw outline
-        //glUseProgram(outlineShader);
-        //glUniformMatrix4fv(glGetUniformLocation(outlineShader, "mvp"), 1, GL_FALSE, glm::value_ptr(mvp));
-        //glLineWidth(3.0f);
-        //glDrawElements(GL_LINES, mesh.edgeIndices.size(), GL_UNSIGNED_INT, 0);
+        // The froxel grid follows the projection; the lists follow the camera
+        if (options.lightCount) {
+            profiler.beginStage(lightStage);
+            clusteredLights.cull(projection, kNearPlane, kFarPlane, framebufferWidth, framebufferHeight);
+            profiler.endStage(lightStage);
+        }
+
+        // Only cascades whose light view, shared rotation or meshes changed are
+        // drawn; the rest keep last frame's depth
+        if (options.shadows) {
+            profiler.beginStage(shadowStage);
+            shadows.update(view, projection, eye, lightDir, sceneSphere, model);
+            if (shadows.anyStale()) {
+                // Every instance casts, culled from the camera or not, through the
+                // position-only stream. This ObjectData matches the one the
+                // instanced paths bound; single draws bind their own again.
+                ObjectUniforms caster;
+                caster.mvp = frame.viewProjection * model;
+                caster.model = model;
+                caster.normalMatrix = glm::mat4(normalMatrix);
+                caster.objectColor = glm::vec4(objectColor, 1.0f);
+                bool casterBound = uniformRing.pushAndBind(kObjectDataBinding, caster);
+                glUseProgram(depthInstancedShader.id);
+                registry.bindCasters();
+                for (unsigned int c = 0; c < shadows.cascadeCount(); c++) {
+                    if (!shadows.stale(c)) continue;
+                    FrameUniforms cascadeFrame = frame;
+                    cascadeFrame.viewProjection = shadows.lightViewProjection(c);
+                    if (!casterBound || !uniformRing.pushAndBind(kFrameDataBinding, cascadeFrame)) {
+                        // Kept stale so it is drawn once the ring has grown
+                        shadows.invalidate();
+                        continue;
+                    }
+                    uniformRing.flush();
+                    shadows.beginCascade(c);
+                    for (size_t m = 0; m < meshCount; m++) {
+                        registry.drawInstanced(static_cast<int>(m), commands[m].instanceCount, commands[m].baseInstance);
+                    }
+                }
+                shadows.endCascades();
+                uniformRing.bindRange(kFrameDataBinding, frameOffset, sizeof(frame));
+            }
+            shadows.bind();
+            profiler.endStage(shadowStage);
+        }
 
+        // The pre-pass fills depth with colour writes off; shading then only
+        // passes for the nearest surface and leaves depth as it is
+        if (options.depthPrepass) {
+            profiler.beginStage(prepassStage);
+            profiler.beginCounter(prepassSamples);
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            submitDraws(true);
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            profiler.endCounter(prepassSamples);
+            profiler.endStage(prepassStage);
+            glDepthFunc(GL_LEQUAL);
+            glDepthMask(GL_FALSE);
+        }
+
+        profiler.beginStage(drawStage);
+        profiler.beginCounter(shadeSamples);
+        if (options.benchmark) {
+            benchmark.beginShading();
+        }
+        submitDraws(false);
+        if (options.benchmark) {
+            benchmark.endShading();
+        }
+        profiler.endCounter(shadeSamples);
+        if (options.depthPrepass) {
+            // Clears only touch depth while writes are on
+            glDepthFunc(GL_LESS);
+            glDepthMask(GL_TRUE);
+        }
+        uniformRing.endFrame();
+        profiler.endStage(drawStage);
+
+        if (options.outline) {
+            profiler.beginStage(outlineStage);
+            outline.end(sceneFramebuffer);
+            profiler.endStage(outlineStage);
+        }
+        profiler.drawOverlay(framebufferWidth, framebufferHeight);
+
+        if (readFrame) {
+            profiler.beginStage(readbackStage);
+            readback.capture(sceneFramebuffer, framebufferWidth, framebufferHeight);
+            if (!options.benchmark) {
+                readback.presentTarget();
+            }
+            profiler.endStage(readbackStage);
+        }
+
+        profiler.beginStage(swapStage);
         glfwSwapBuffers(window);
+        profiler.endStage(swapStage);
         glfwPollEvents();
+        heldKeys = cameraKeys(window);
+        simulation.setInput(heldKeys);
+        profiler.endFrame();
+        if (options.onDemand) {
+            SceneState scene{ view, projection, model, lightDir, lightColor, framebufferWidth, framebufferHeight };
+            redraw.drawn(scene);
+            idleTitle = false;
+        }
+        if (options.benchmark) {
+            benchmark.endFrame();
+        }
+
+        fpsFrames++;
+        double now = glfwGetTime();
+        if (now - fpsWindowStart >= 1.0) {
+            const char* modeNames[] = { " draws, ", " instanced, ", " indirect, " };
+            std::string title = "Red Teapot with Lighting - " + std::to_string(instances.size()) +
+                modeNames[static_cast<int>(options.drawMode)] +
+                std::to_string(static_cast<int>(fpsFrames / (now - fpsWindowStart) + 0.5)) + " fps";
+            if (streaming) {
+                title += ", streaming " + std::to_string(streamer.pendingBytes() / 1024) + " KB";
+            }
+            glfwSetWindowTitle(window, title.c_str());
+            if (profiler.enabled()) {
+                std::cout << profiler.summary() << std::flush;
+            }
+            fpsWindowStart = now;
+            fpsFrames = 0;
+        }
+    }
+
+    int exitCode = 0;
+    if (options.benchmark) {
+        exitCode = benchmark.writeJson(options.benchmarkOut, options, meshCount, instances.size()) ? 0 : 1;
+        benchmark.destroy();
+    }
+    if (options.shadows) {
+        std::cout << "Shadow cascades: " << shadows.renderedCascades() << " drawn, " << shadows.cachedCascades()
+                  << " kept from the frame before" << std::endl;
+    }
+    if (options.memoryReport) {
+        std::cout << memoryReport.summary(registry.allocatedBytes()) << std::flush;
+    }
+    if (!options.readbackOut.empty()) {
+        readback.destroy();
+        std::cout << "Readback: " << readback.capturedFrames() << " frames captured, " << readback.deliveredFrames()
+                  << " delivered, " << readback.droppedFrames() << " dropped" << std::endl;
+    }
+    if (options.onDemand) {
+        std::cout << "On demand: " << redraw.drawnFrames() << " frames drawn, " << redraw.idleWaits()
+                  << " idle waits" << std::endl;
+    }
+    if (profiler.enabled()) {
+        profiler.finish();
+        std::cout << profiler.summary() << std::flush;
+        if (!options.profileCsv.empty()) profiler.writeCsv(options.profileCsv.c_str());
+        if (!options.profileTrace.empty()) profiler.writeChromeTrace(options.profileTrace.c_str());
     }
 
     // Cleanup
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
-    glDeleteBuffers(1, &NBO);
-    glDeleteProgram(mainShader);
-    glDeleteProgram(outlineShader);
+    profiler.destroy();
+    streamer.destroy();
+    registry.destroy();
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteBuffers(1, &materialBuffer);
+    if (options.meshlets) {
+        meshletCuller.destroy();
+    }
+    else if (options.drawMode == DrawMode::Indirect && options.gpuCull) {
+        culler.destroy();
+    }
+    else {
+        glDeleteBuffers(1, &indirectBuffer);
+    }
+    uniformRing.destroy();
+    outline.destroy();
+    clusteredLights.destroy();
+    shadows.destroy();
+    programs.destroy();
 
     glfwTerminate();
-    return 0;
+    return exitCode;
 }
\ No newline at end of file
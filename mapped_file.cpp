@@ -0,0 +1,88 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char* path) {
+    close();
+    fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        fileHandle = nullptr;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) {
+        close();
+        return false;
+    }
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        close();
+        return false;
+    }
+    mapped = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!mapped) {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapped) UnmapViewOfFile(mapped);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+    mapped = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+    length = 0;
+}
+
+#else
+
+bool MappedFile::open(const char* path) {
+    close();
+    fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close();
+        return false;
+    }
+    void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+        close();
+        return false;
+    }
+    mapped = static_cast<const unsigned char*>(address);
+    length = static_cast<size_t>(info.st_size);
+    madvise(address, length, MADV_SEQUENTIAL);
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapped) munmap(const_cast<unsigned char*>(mapped), length);
+    if (fd >= 0) ::close(fd);
+    mapped = nullptr;
+    fd = -1;
+    length = 0;
+}
+
+#endif
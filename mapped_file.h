@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. The mapping lives until close() or
+// destruction, so pointers into data() must not outlive the object.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const char* path);
+    void close();
+
+    const unsigned char* data() const { return mapped; }
+    size_t size() const { return length; }
+    bool isOpen() const { return mapped != nullptr; }
+
+private:
+    const unsigned char* mapped = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
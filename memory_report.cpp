@@ -0,0 +1,105 @@
+#include "memory_report.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#ifdef _WIN32
+
+static bool processMemory(PROCESS_MEMORY_COUNTERS& counters) {
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) != 0;
+}
+
+size_t residentBytes() {
+    PROCESS_MEMORY_COUNTERS counters;
+    return processMemory(counters) ? counters.WorkingSetSize : 0;
+}
+
+size_t peakResidentBytes() {
+    PROCESS_MEMORY_COUNTERS counters;
+    return processMemory(counters) ? counters.PeakWorkingSetSize : 0;
+}
+
+#else
+
+// A "Vm...:  1234 kB" line of /proc/self/status, in bytes; 0 without procfs
+static size_t statusField(const char* field) {
+    FILE* file = std::fopen("/proc/self/status", "r");
+    if (!file) {
+        return 0;
+    }
+    size_t bytes = 0;
+    char line[256];
+    size_t length = std::strlen(field);
+    while (std::fgets(line, sizeof(line), file)) {
+        if (std::strncmp(line, field, length) == 0 && line[length] == ':') {
+            bytes = static_cast<size_t>(std::strtoull(line + length + 1, nullptr, 10)) * 1024;
+            break;
+        }
+    }
+    std::fclose(file);
+    return bytes;
+}
+
+size_t residentBytes() {
+    return statusField("VmRSS");
+}
+
+size_t peakResidentBytes() {
+    size_t peak = statusField("VmHWM");
+    if (peak == 0) {
+        // No procfs (macOS and the BSDs): ru_maxrss is bytes on macOS, KB elsewhere
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+            peak = static_cast<size_t>(usage.ru_maxrss);
+#else
+            peak = static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+        }
+    }
+    return peak;
+}
+
+#endif
+
+void MemoryReport::addAsset(const std::string& name, size_t scratchBytes, size_t hostBytes, size_t deviceBytes) {
+    assets.push_back(Asset{ name, scratchBytes, hostBytes, deviceBytes });
+}
+
+void MemoryReport::markUploaded() {
+    uploadedResident = residentBytes();
+    uploadedPeak = peakResidentBytes();
+}
+
+static std::string kilobytes(size_t bytes) {
+    return std::to_string((bytes + 1023) / 1024) + " KB";
+}
+
+std::string MemoryReport::summary(size_t meshBufferBytes) const {
+    std::ostringstream out;
+    out << "Memory per asset (parse scratch, CPU copy until upload, GPU mesh data):\n";
+    size_t scratch = 0, host = 0, device = 0;
+    for (const Asset& asset : assets) {
+        out << "  " << asset.name << ": " << kilobytes(asset.scratchBytes) << ", " << kilobytes(asset.hostBytes)
+            << ", " << kilobytes(asset.deviceBytes) << "\n";
+        scratch += asset.scratchBytes;
+        host += asset.hostBytes;
+        device += asset.deviceBytes;
+    }
+    out << "  total: " << kilobytes(scratch) << ", " << kilobytes(host) << ", " << kilobytes(device)
+        << "; mesh buffers allocated " << kilobytes(meshBufferBytes) << "\n";
+    out << "Resident: " << kilobytes(uploadedResident) << " after upload (peak " << kilobytes(uploadedPeak)
+        << "), " << kilobytes(residentBytes()) << " now (peak " << kilobytes(peakResidentBytes()) << ")\n";
+    return out.str();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Resident set of the process now and at its peak, as the OS reports it; 0
+// where it cannot be read
+size_t residentBytes();
+size_t peakResidentBytes();
+
+// Memory spent per asset for --memory-report: the parse's scratch arena, the
+// CPU copy held until it is on the GPU, and what it takes in the mesh buffers.
+// The process numbers are sampled when the CPU copies are dropped and at the
+// end, so the report shows what loading cost and what a loaded scene keeps.
+class MemoryReport {
+public:
+    void addAsset(const std::string& name, size_t scratchBytes, size_t hostBytes, size_t deviceBytes);
+    // Call right after the CPU copies are freed
+    void markUploaded();
+
+    // One line per asset, then the totals; `meshBufferBytes` is the registry as allocated
+    std::string summary(size_t meshBufferBytes) const;
+
+private:
+    struct Asset {
+        std::string name;
+        size_t scratchBytes;
+        size_t hostBytes;
+        size_t deviceBytes;
+    };
+
+    std::vector<Asset> assets;
+    size_t uploadedResident = 0;
+    size_t uploadedPeak = 0;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// One welded vertex: every unique v/vt/vn corner of the OBJ becomes one of these,
+// so positions, normals and texture coordinates share a single index buffer.
+struct Vertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+};
+
+// Axis-aligned box plus a bounding sphere around the box centre, in object space
+struct Bounds {
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+};
+
+// One level of detail: a range of Mesh::indices over the shared vertices, and
+// the object-space error of drawing it in place of the full mesh
+struct MeshLod {
+    unsigned int firstIndex = 0;
+    unsigned int indexCount = 0;
+    float error = 0.0f;
+};
+
+const unsigned int kMaxLods = 4;
+
+// A cluster of at most 64 vertices and 124 triangles: a contiguous range of the
+// level 0 indices with bounds for culling it on its own. Laid out for std430.
+struct Meshlet {
+    glm::vec4 sphere;           // object-space centre and radius
+    glm::vec4 cone;             // normal cone axis and the sine of its half-angle; w > 1 when it cannot cull
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    unsigned int vertexCount;
+    unsigned int padding;
+};
+
+// Phong parameters of one MTL "newmtl" block (Ka, Kd, Ks, Ns). Statements a
+// block leaves out keep these values: matte, with no highlight.
+struct Material {
+    std::string name;
+    glm::vec3 ambient = glm::vec3(0.2f);
+    glm::vec3 diffuse = glm::vec3(0.8f);
+    glm::vec3 specular = glm::vec3(0.0f);
+    float shininess = 32.0f;
+};
+
+// The triangles that share one "usemtl": a range of Mesh::indices. `material`
+// indexes Mesh::materials, or is -1 for faces before the first usemtl.
+struct Submesh {
+    unsigned int firstIndex = 0;
+    unsigned int indexCount = 0;
+    int material = -1;
+};
+
+struct Mesh {
+    std::vector<Vertex> vertices;
+    // Level 0 first, followed by the coarser levels when lods is filled in
+    std::vector<unsigned int> indices;
+    Bounds bounds;
+    // Empty until buildLodChain(); then lods[0] is the full mesh
+    std::vector<MeshLod> lods;
+    // Empty until buildMeshlets(); covers level 0
+    std::vector<Meshlet> meshlets;
+    // Filled in by loadOBJ when the file uses materials; the triangles are then
+    // grouped by material, one submesh per group in order of first use
+    std::vector<Material> materials;
+    std::vector<Submesh> submeshes;
+    // Every mtllib the file names, as opened (relative to the OBJ's directory),
+    // whether or not it could be read; the mesh cache stamps them
+    std::vector<std::string> materialLibraries;
+};
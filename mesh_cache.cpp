@@ -0,0 +1,282 @@
+#include "mesh_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <system_error>
+
+// Bump whenever the header or the packed vertex formats change
+static const uint32_t kCacheVersion = 7;
+static const char kCacheMagic[4] = { 'M', 'S', 'H', 'C' };
+
+// mtllib files stamped per cache; an OBJ naming more is not cached
+static const uint32_t kMaxCachedLibraries = 4;
+
+// One mtllib as the parse opened it. A library that was missing is recorded
+// too, so it turning up later also invalidates the cache.
+struct LibraryStamp {
+    char path[256];
+    uint32_t present;
+    uint32_t reserved;
+    uint64_t size;
+    int64_t time;
+    uint64_t hash;
+};
+
+struct MeshCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t layout;
+    uint32_t stride;
+    uint32_t optimized;
+    uint32_t lodCount;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t meshletCount;
+    uint64_t meshletOffset;
+    float boundsMin[3];
+    float boundsMax[3];
+    float boundingSphere[4];
+    float positionOffset[3];
+    float positionScale[3];
+    MeshLod lods[kMaxLods];
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t sourceHash;
+    uint32_t partCount;
+    uint32_t hasMaterial;
+    float ambient[3];
+    float diffuse[3];
+    float specular[3];
+    float shininess;
+    char materialName[64];
+    uint32_t libraryCount;
+    uint32_t reserved;
+    LibraryStamp libraries[kMaxCachedLibraries];
+};
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Word-at-a-time multiply/xorshift hash; fast enough to stay I/O-bound
+static uint64_t hashBytes(const unsigned char* data, size_t size) {
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        h = (h ^ word) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    for (; i < size; i++) {
+        h = (h ^ data[i]) * 0x100000001B3ull;
+    }
+    return h ^ (h >> 29);
+}
+
+static bool hashFile(const char* path, uint64_t& hash) {
+    MappedFile source;
+    if (!source.open(path)) {
+        return false;
+    }
+    hash = hashBytes(source.data(), source.size());
+    return true;
+}
+
+struct SourceStamp {
+    uint64_t size = 0;
+    int64_t time = 0;
+};
+
+static bool stampFile(const char* path, SourceStamp& stamp) {
+    std::error_code error;
+    std::filesystem::path file(path);
+    stamp.size = std::filesystem::file_size(file, error);
+    if (error) return false;
+    stamp.time = std::filesystem::last_write_time(file, error).time_since_epoch().count();
+    return !error;
+}
+
+// Same rule as the OBJ itself: size must match, a new mtime is confirmed by hash
+static bool libraryUnchanged(const LibraryStamp& library) {
+    SourceStamp stamp;
+    bool present = stampFile(library.path, stamp);
+    if (present != (library.present != 0)) {
+        return false;
+    }
+    if (!present) {
+        return true;
+    }
+    uint64_t hash = 0;
+    return stamp.size == library.size &&
+           (stamp.time == library.time || (hashFile(library.path, hash) && hash == library.hash));
+}
+
+std::string meshCachePath(const char* objPath, unsigned int part) {
+    return std::string(objPath) + (part > 0 ? "." + std::to_string(part) : std::string()) + ".meshcache";
+}
+
+bool MeshCache::open(const char* objPath, unsigned int part, VertexLayout layout, bool optimized) {
+    close();
+    SourceStamp stamp;
+    if (!stampFile(objPath, stamp) || !file.open(meshCachePath(objPath, part).c_str())) {
+        return false;
+    }
+
+    MeshCacheHeader header;
+    if (file.size() < sizeof(header)) {
+        close();
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    bool valid = std::memcmp(header.magic, kCacheMagic, 4) == 0 &&
+                 header.version == kCacheVersion &&
+                 header.layout == static_cast<uint32_t>(layout) &&
+                 header.stride == vertexStride(layout) &&
+                 header.optimized == (optimized ? 1u : 0u) &&
+                 header.sourceSize == stamp.size &&
+                 header.vertexOffset + header.vertexCount * header.stride <= file.size() &&
+                 header.indexOffset + header.indexCount * sizeof(unsigned int) <= file.size() &&
+                 header.meshletOffset + header.meshletCount * sizeof(Meshlet) <= file.size() &&
+                 header.lodCount >= 1 && header.lodCount <= kMaxLods &&
+                 header.libraryCount <= kMaxCachedLibraries &&
+                 part < header.partCount;
+
+    // A touched but unchanged source (same size, new mtime) is confirmed by hash
+    uint64_t sourceHash = 0;
+    if (valid && header.sourceTime != stamp.time) {
+        valid = hashFile(objPath, sourceHash) && sourceHash == header.sourceHash;
+    }
+    for (uint32_t i = 0; valid && i < header.libraryCount; i++) {
+        header.libraries[i].path[sizeof(header.libraries[i].path) - 1] = '\0';
+        valid = libraryUnchanged(header.libraries[i]);
+    }
+    if (!valid) {
+        close();
+        return false;
+    }
+
+    meshView.layout = layout;
+    meshView.stride = header.stride;
+    meshView.vertexData = file.data() + header.vertexOffset;
+    meshView.vertexCount = static_cast<size_t>(header.vertexCount);
+    meshView.indexData = reinterpret_cast<const unsigned int*>(file.data() + header.indexOffset);
+    meshView.indexCount = static_cast<size_t>(header.indexCount);
+    meshView.bounds.min = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    meshView.bounds.max = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    meshView.bounds.center = glm::vec3(header.boundingSphere[0], header.boundingSphere[1], header.boundingSphere[2]);
+    meshView.bounds.radius = header.boundingSphere[3];
+    meshView.positionOffset = glm::vec3(header.positionOffset[0], header.positionOffset[1], header.positionOffset[2]);
+    meshView.positionScale = glm::vec3(header.positionScale[0], header.positionScale[1], header.positionScale[2]);
+    meshView.lods.assign(header.lods, header.lods + header.lodCount);
+    meshView.meshletData = reinterpret_cast<const Meshlet*>(file.data() + header.meshletOffset);
+    meshView.meshletCount = static_cast<size_t>(header.meshletCount);
+    parts = header.partCount;
+    hasMaterial = header.hasMaterial != 0;
+    if (hasMaterial) {
+        partMaterial.name.assign(header.materialName, std::find(header.materialName, std::end(header.materialName), '\0'));
+        partMaterial.ambient = glm::vec3(header.ambient[0], header.ambient[1], header.ambient[2]);
+        partMaterial.diffuse = glm::vec3(header.diffuse[0], header.diffuse[1], header.diffuse[2]);
+        partMaterial.specular = glm::vec3(header.specular[0], header.specular[1], header.specular[2]);
+        partMaterial.shininess = header.shininess;
+    }
+    return true;
+}
+
+bool writeMeshCache(const char* objPath, unsigned int part, unsigned int partCount, const MeshView& view,
+                    bool optimized, const Material* material, const std::vector<std::string>& materialLibraries) {
+    SourceStamp stamp;
+    uint64_t sourceHash = 0;
+    if (!stampFile(objPath, stamp) || !hashFile(objPath, sourceHash) || materialLibraries.size() > kMaxCachedLibraries) {
+        return false;
+    }
+
+    MeshCacheHeader header = {};
+    header.libraryCount = static_cast<uint32_t>(materialLibraries.size());
+    for (uint32_t i = 0; i < header.libraryCount; i++) {
+        LibraryStamp& library = header.libraries[i];
+        if (materialLibraries[i].size() >= sizeof(library.path)) {
+            return false;
+        }
+        materialLibraries[i].copy(library.path, sizeof(library.path) - 1);
+        SourceStamp libraryStamp;
+        library.present = stampFile(library.path, libraryStamp) && hashFile(library.path, library.hash) ? 1u : 0u;
+        library.size = libraryStamp.size;
+        library.time = libraryStamp.time;
+    }
+    std::memcpy(header.magic, kCacheMagic, 4);
+    header.version = kCacheVersion;
+    header.layout = static_cast<uint32_t>(view.layout);
+    header.stride = view.stride;
+    header.optimized = optimized ? 1u : 0u;
+    header.vertexCount = view.vertexCount;
+    header.indexCount = view.indexCount;
+    // Sections are 64-byte aligned so the mapped ranges suit any upload path
+    header.vertexOffset = alignUp(sizeof(header), 64);
+    header.indexOffset = alignUp(header.vertexOffset + view.vertexCount * view.stride, 64);
+    header.meshletCount = view.meshletCount;
+    header.meshletOffset = alignUp(header.indexOffset + view.indexCount * sizeof(unsigned int), 64);
+    for (int i = 0; i < 3; i++) {
+        header.boundsMin[i] = view.bounds.min[i];
+        header.boundsMax[i] = view.bounds.max[i];
+        header.positionOffset[i] = view.positionOffset[i];
+        header.positionScale[i] = view.positionScale[i];
+        header.boundingSphere[i] = view.bounds.center[i];
+    }
+    header.boundingSphere[3] = view.bounds.radius;
+    header.lodCount = static_cast<uint32_t>(std::min<size_t>(view.lods.size(), kMaxLods));
+    std::copy(view.lods.begin(), view.lods.begin() + header.lodCount, header.lods);
+    header.sourceSize = stamp.size;
+    header.sourceTime = stamp.time;
+    header.sourceHash = sourceHash;
+    header.partCount = partCount;
+    header.hasMaterial = material ? 1u : 0u;
+    if (material) {
+        for (int i = 0; i < 3; i++) {
+            header.ambient[i] = material->ambient[i];
+            header.diffuse[i] = material->diffuse[i];
+            header.specular[i] = material->specular[i];
+        }
+        header.shininess = material->shininess;
+        // Only kept for reports, so a long name is cut short
+        material->name.copy(header.materialName, sizeof(header.materialName) - 1);
+    }
+
+    // Written to a temporary name first so a crash never leaves a torn cache
+    std::string path = meshCachePath(objPath, part);
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        const char padding[64] = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(padding, header.vertexOffset - sizeof(header));
+        out.write(static_cast<const char*>(view.vertexData), view.vertexCount * view.stride);
+        out.write(padding, header.indexOffset - (header.vertexOffset + view.vertexCount * view.stride));
+        out.write(reinterpret_cast<const char*>(view.indexData), view.indexCount * sizeof(unsigned int));
+        out.write(padding, header.meshletOffset - (header.indexOffset + view.indexCount * sizeof(unsigned int)));
+        out.write(reinterpret_cast<const char*>(view.meshletData), view.meshletCount * sizeof(Meshlet));
+        if (!out) {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::cerr << "Failed to write mesh cache " << path << ": " << error.message() << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
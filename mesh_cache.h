@@ -0,0 +1,43 @@
+#pragma once
+
+#include "gpu_mesh.h"
+#include "mapped_file.h"
+
+#include <string>
+#include <vector>
+
+// Binary cache written next to an .obj ("teapot.obj.meshcache") after the first
+// parse. It holds the packed, optimized vertex and index buffers exactly as they
+// are uploaded, so a warm start maps the file and hands the ranges to the GPU.
+// An OBJ with several materials is split into parts with one cache file each;
+// part 0 records how many there are. The resolved material is stored too, so
+// the OBJ's mtllib files are stamped alongside it and any edit, removal or
+// new file among them invalidates the cache.
+class MeshCache {
+public:
+    // Maps the cache for `objPath` if it exists, matches the source file and its
+    // material libraries and was built with the same layout and optimization setting
+    bool open(const char* objPath, unsigned int part, VertexLayout layout, bool optimized);
+    void close() { file.close(); }
+
+    // Point into the mapping; only valid while the cache stays open
+    const MeshView& view() const { return meshView; }
+    unsigned int partCount() const { return parts; }
+    // Null when the part has no material
+    const Material* material() const { return hasMaterial ? &partMaterial : nullptr; }
+
+private:
+    MappedFile file;
+    MeshView meshView;
+    unsigned int parts = 1;
+    bool hasMaterial = false;
+    Material partMaterial;
+};
+
+// "teapot.obj.meshcache" for part 0, "teapot.obj.1.meshcache" for part 1
+std::string meshCachePath(const char* objPath, unsigned int part = 0);
+
+// Writes nothing and returns false when the OBJ names more material libraries
+// than the header has room for, so such files are always re-parsed
+bool writeMeshCache(const char* objPath, unsigned int part, unsigned int partCount, const MeshView& view,
+                    bool optimized, const Material* material, const std::vector<std::string>& materialLibraries);
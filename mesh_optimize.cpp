@@ -0,0 +1,276 @@
+#include "mesh_optimize.h"
+
+#include <algorithm>
+#include <cmath>
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize) {
+    VertexCacheStats stats;
+    if (indices.empty()) {
+        return stats;
+    }
+
+    // Each vertex remembers the miss counter value when it entered the FIFO
+    std::vector<unsigned int> timestamps(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    unsigned int misses = 0;
+    size_t uniqueVertices = 0;
+    for (unsigned int index : indices) {
+        if (!referenced[index]) {
+            referenced[index] = true;
+            uniqueVertices++;
+        }
+        if (timestamps[index] == 0 || misses + 1 - timestamps[index] > cacheSize) {
+            misses++;
+            timestamps[index] = misses;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(uniqueVertices);
+    return stats;
+}
+
+// Forsyth's scoring constants, from "Linear-Speed Vertex Cache Optimisation"
+static const int kCacheSize = 32;
+static const float kCacheDecayPower = 1.5f;
+static const float kLastTriangleScore = 0.75f;
+static const float kValenceBoostScale = 2.0f;
+static const float kValenceBoostPower = 0.5f;
+
+static float vertexScore(int cachePosition, unsigned int remainingTriangles) {
+    if (remainingTriangles == 0) {
+        return -1.0f;
+    }
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // The triangle just emitted; its vertices are penalised so the next
+            // triangle does not simply fan around the same edge
+            score = kLastTriangleScore;
+        }
+        else {
+            float scaler = 1.0f / (kCacheSize - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, kCacheDecayPower);
+        }
+    }
+    // Vertices with few triangles left get a boost so they are finished off early
+    score += kValenceBoostScale * std::pow(static_cast<float>(remainingTriangles), -kValenceBoostPower);
+    return score;
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Vertex -> triangle adjacency in one flat array; live triangles of vertex v
+    // are adjacency[offsets[v] .. offsets[v] + remaining[v])
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (unsigned int index : indices) remaining[index]++;
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> scores(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) scores[v] = vertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+    }
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(kCacheSize + 3);
+    nextCache.reserve(kCacheSize + 3);
+
+    size_t bestTriangle = std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin();
+    size_t scanCursor = 0;
+
+    while (output.size() < indices.size()) {
+        // Cache ran dry: restart from the first triangle not yet emitted
+        if (bestTriangle == triangleCount) {
+            while (emitted[scanCursor]) scanCursor++;
+            bestTriangle = scanCursor;
+        }
+
+        const unsigned int* corners = &indices[bestTriangle * 3];
+        emitted[bestTriangle] = true;
+        nextCache.clear();
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = corners[k];
+            output.push_back(v);
+            nextCache.push_back(v);
+
+            unsigned int* live = &adjacency[offsets[v]];
+            unsigned int* slot = std::find(live, live + remaining[v], static_cast<unsigned int>(bestTriangle));
+            *slot = live[--remaining[v]];
+        }
+        for (unsigned int v : cache) {
+            if (v != corners[0] && v != corners[1] && v != corners[2]) nextCache.push_back(v);
+        }
+
+        // Re-score everything that moved in the cache, including vertices that fell out
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            unsigned int v = nextCache[i];
+            cachePosition[v] = i < kCacheSize ? static_cast<int>(i) : -1;
+            float score = vertexScore(cachePosition[v], remaining[v]);
+            float delta = score - scores[v];
+            scores[v] = score;
+            for (unsigned int a = 0; a < remaining[v]; a++) triangleScores[adjacency[offsets[v] + a]] += delta;
+        }
+        if (nextCache.size() > kCacheSize) nextCache.resize(kCacheSize);
+        cache.swap(nextCache);
+
+        // The next triangle is the best one touching a cached vertex
+        bestTriangle = triangleCount;
+        float bestScore = -1.0f;
+        for (unsigned int v : cache) {
+            for (unsigned int a = 0; a < remaining[v]; a++) {
+                unsigned int t = adjacency[offsets[v] + a];
+                if (triangleScores[t] > bestScore) {
+                    bestScore = triangleScores[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+    }
+
+    indices.swap(output);
+}
+
+struct Cluster {
+    size_t first;
+    size_t count;
+    float sortKey;
+};
+
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, float threshold) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Find cluster boundaries with the same FIFO model analyzeVertexCache uses.
+    // A triangle whose three vertices all miss starts a hard cluster; inside one,
+    // a split is allowed once the cluster's own ACMR is within the threshold.
+    // The cache is flushed at every boundary, because once clusters are sorted
+    // each of them starts cold.
+    const unsigned int cacheSize = 16;
+    float meshAcmr = analyzeVertexCache(indices, vertices.size(), cacheSize).acmr;
+    std::vector<unsigned int> timestamps(vertices.size(), 0);
+    std::vector<Cluster> clusters;
+    unsigned int misses = cacheSize, clusterMisses = 0;
+    size_t clusterStart = 0;
+
+    auto isCached = [&](unsigned int index) {
+        return misses - timestamps[index] < cacheSize;
+    };
+
+    for (size_t t = 0; t < triangleCount; t++) {
+        const unsigned int* corners = &indices[t * 3];
+        size_t clusterTriangles = t - clusterStart;
+        bool hardBoundary = !isCached(corners[0]) && !isCached(corners[1]) && !isCached(corners[2]);
+        bool softBoundary = static_cast<float>(clusterMisses) / clusterTriangles <= threshold * meshAcmr;
+        if (clusterTriangles > 0 && (hardBoundary || softBoundary)) {
+            clusters.push_back(Cluster{ clusterStart, clusterTriangles, 0.0f });
+            clusterStart = t;
+            clusterMisses = 0;
+            misses += cacheSize;
+        }
+
+        for (int k = 0; k < 3; k++) {
+            if (!isCached(corners[k])) {
+                misses++;
+                clusterMisses++;
+                timestamps[corners[k]] = misses;
+            }
+        }
+    }
+    clusters.push_back(Cluster{ clusterStart, triangleCount - clusterStart, 0.0f });
+
+    // Sort key: how far the cluster faces away from the mesh centre. Outward
+    // facing clusters are likely occluders for the rest, so they are drawn first.
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> clusterCentroids(clusters.size()), clusterNormals(clusters.size());
+    for (size_t c = 0; c < clusters.size(); c++) {
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = clusters[c].first; t < clusters[c].first + clusters[c].count; t++) {
+            const glm::vec3& a = vertices[indices[t * 3]].position;
+            const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& d = vertices[indices[t * 3 + 2]].position;
+            glm::vec3 n = glm::cross(b - a, d - a);
+            float triangleArea = glm::length(n);
+            centroid += (a + b + d) * (triangleArea / 3.0f);
+            normal += n;
+            area += triangleArea;
+        }
+        meshCentroid += centroid;
+        meshArea += area;
+        clusterCentroids[c] = area > 0.0f ? centroid / area : centroid;
+        clusterNormals[c] = normal;
+    }
+    if (meshArea > 0.0f) meshCentroid /= meshArea;
+    for (size_t c = 0; c < clusters.size(); c++) {
+        float length = glm::length(clusterNormals[c]);
+        clusters[c].sortKey = length > 0.0f ? glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c] / length) : 0.0f;
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(),
+        [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    for (const Cluster& cluster : clusters) {
+        output.insert(output.end(), indices.begin() + cluster.first * 3, indices.begin() + (cluster.first + cluster.count) * 3);
+    }
+
+    // Vertices shared across sorted clusters can still push ACMR past the
+    // threshold; the cache order is worth more than the overdraw win then
+    if (analyzeVertexCache(output, vertices.size(), cacheSize).acmr <= threshold * meshAcmr) {
+        indices.swap(output);
+    }
+}
+
+void optimizeVertexFetch(Mesh& mesh) {
+    const unsigned int unassigned = ~0u;
+    std::vector<unsigned int> remap(mesh.vertices.size(), unassigned);
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    for (unsigned int& index : mesh.indices) {
+        if (remap[index] == unassigned) {
+            remap[index] = static_cast<unsigned int>(vertices.size());
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices.swap(vertices);
+}
+
+MeshOptimizeReport optimizeMesh(Mesh& mesh) {
+    MeshOptimizeReport report;
+    report.before = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+    // Some exporters already emit cache-friendly strips (teapot.obj is at the
+    // 792/992 lower bound); keep the file order when Forsyth cannot beat it
+    std::vector<unsigned int> original = mesh.indices;
+    optimizeVertexCache(mesh.indices, mesh.vertices.size());
+    if (analyzeVertexCache(mesh.indices, mesh.vertices.size()).acmr > report.before.acmr) {
+        mesh.indices.swap(original);
+    }
+    optimizeOverdraw(mesh.indices, mesh.vertices);
+    optimizeVertexFetch(mesh);
+    report.after = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+    return report;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <vector>
+
+// Post-transform cache efficiency of an index buffer, simulated with a FIFO cache.
+// ACMR is cache misses per triangle (0.5 is ideal for large regular meshes, 3 is
+// worst); ATVR is misses per referenced vertex (1.0 is ideal).
+struct VertexCacheStats {
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+struct MeshOptimizeReport {
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = 16);
+
+// Reorders triangles for the post-transform vertex cache (Forsyth's linear-speed
+// algorithm with a 32-entry LRU model).
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+
+// Splits a cache-optimized index buffer into clusters and draws the outward
+// facing ones first (Sander et al., "Fast triangle reordering"). `threshold`
+// bounds how much ACMR may degrade, e.g. 1.05 allows 5%; if the sorted order
+// exceeds it the input order is kept.
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, float threshold = 1.05f);
+
+// Renumbers vertices in first-use order so the VBO is read sequentially, and
+// drops vertices no triangle references.
+void optimizeVertexFetch(Mesh& mesh);
+
+// Runs the three passes above in order and reports the cache stats around them
+MeshOptimizeReport optimizeMesh(Mesh& mesh);
@@ -0,0 +1,247 @@
+#include "mesh_registry.h"
+#include "instancing.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <iostream>
+
+// Immutable storage where available; contents still change through glBufferSubData
+static void allocateBuffer(GLenum target, size_t size) {
+    if (GLAD_GL_VERSION_4_4) {
+        glBufferStorage(target, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+    else {
+        glBufferData(target, size, nullptr, GL_STATIC_DRAW);
+    }
+}
+
+// Moves the first `used` bytes of `buffer` into a fresh buffer of `size` bytes
+static unsigned int regrowBuffer(GLenum target, unsigned int buffer, size_t used, size_t size) {
+    unsigned int grown;
+    glGenBuffers(1, &grown);
+    glBindBuffer(target, grown);
+    allocateBuffer(target, size);
+    if (buffer != 0) {
+        if (used > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, target, 0, 0, used);
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+    return grown;
+}
+
+void MeshRegistry::create(VertexLayout layout, size_t vertices, size_t indices) {
+    vertexLayout = layout;
+    stride = vertexStride(layout);
+    glGenVertexArrays(1, &VAO);
+    reserve(vertices, indices);
+}
+
+void MeshRegistry::enablePositionStream() {
+    glGenVertexArrays(1, &positionVAO);
+    glBindVertexArray(positionVAO);
+    positionVBO = regrowBuffer(GL_ARRAY_BUFFER, 0, 0, vertexCapacity * positionStride(vertexLayout));
+    positionCapacity = vertexCapacity;
+    setupPositionAttribute(vertexLayout);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBindVertexArray(0);
+}
+
+size_t MeshRegistry::meshBytes(int id) const {
+    const MeshRange& range = meshes[id];
+    size_t positions = positionVBO ? positionStride(vertexLayout) : 0;
+    return range.vertexCount * (stride + positions) + range.indexCount * sizeof(unsigned int);
+}
+
+size_t MeshRegistry::allocatedBytes() const {
+    size_t positions = positionVBO ? positionCapacity * positionStride(vertexLayout) : 0;
+    return vertexCapacity * stride + indexCapacity * sizeof(unsigned int) + positions;
+}
+
+void MeshRegistry::destroy() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    glDeleteVertexArrays(1, &positionVAO);
+    glDeleteBuffers(1, &positionVBO);
+    glDeleteVertexArrays(1, &casterVAO);
+    *this = MeshRegistry();
+}
+
+void MeshRegistry::reserve(size_t vertices, size_t indices) {
+    glBindVertexArray(VAO);
+    if (vertices > vertexCapacity) {
+        VBO = regrowBuffer(GL_ARRAY_BUFFER, VBO, vertexCount * stride, vertices * stride);
+        vertexCapacity = vertices;
+        setupVertexAttributes(vertexLayout);
+    }
+    if (indices > indexCapacity) {
+        // The element binding is VAO state, so binding the new buffer re-points it
+        EBO = regrowBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO, indexCount * sizeof(unsigned int), indices * sizeof(unsigned int));
+        indexCapacity = indices;
+    }
+    if (positionVAO != 0) {
+        glBindVertexArray(positionVAO);
+        if (vertices > positionCapacity) {
+            size_t size = positionStride(vertexLayout);
+            positionVBO = regrowBuffer(GL_ARRAY_BUFFER, positionVBO, vertexCount * size, vertices * size);
+            positionCapacity = vertices;
+            setupPositionAttribute(vertexLayout);
+            if (casterVAO != 0) {
+                glBindVertexArray(casterVAO);
+                setupPositionAttribute(vertexLayout);
+            }
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        if (casterVAO != 0) {
+            glBindVertexArray(casterVAO);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        }
+    }
+    glBindVertexArray(0);
+}
+
+int MeshRegistry::allocate(const MeshView& view) {
+    if (view.layout != vertexLayout) {
+        std::cerr << "Mesh layout " << vertexLayoutName(view.layout) << " does not match the registry layout "
+                  << vertexLayoutName(vertexLayout) << std::endl;
+        return -1;
+    }
+
+    // Double on overflow so a scene of many small meshes copies O(log n) times
+    if (vertexCount + view.vertexCount > vertexCapacity || indexCount + view.indexCount > indexCapacity) {
+        reserve(std::max(vertexCapacity * 2, vertexCount + view.vertexCount),
+                std::max(indexCapacity * 2, indexCount + view.indexCount));
+    }
+
+    MeshRange range;
+    range.firstIndex = static_cast<unsigned int>(indexCount);
+    range.indexCount = static_cast<unsigned int>(view.indexCount);
+    range.baseVertex = static_cast<int>(vertexCount);
+    range.vertexCount = static_cast<unsigned int>(view.vertexCount);
+    range.bounds = view.bounds;
+    range.positionOffset = view.positionOffset;
+    range.positionScale = view.positionScale;
+    range.lods = view.lods;
+    range.meshlets.assign(view.meshletData, view.meshletData + view.meshletCount);
+    range.residentLod = static_cast<unsigned int>(view.lods.size());
+
+    vertexCount += view.vertexCount;
+    indexCount += view.indexCount;
+    meshes.push_back(range);
+    return static_cast<int>(meshes.size() - 1);
+}
+
+int MeshRegistry::add(const MeshView& view) {
+    int id = allocate(view);
+    if (id < 0) {
+        return -1;
+    }
+    const MeshRange& range = meshes[id];
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, range.baseVertex * static_cast<size_t>(stride), view.vertexCount * stride, view.vertexData);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, range.firstIndex * sizeof(unsigned int), view.indexCount * sizeof(unsigned int), view.indexData);
+    writePositions(id, view.vertexData);
+    meshes[id].residentLod = 0;
+    return id;
+}
+
+void MeshRegistry::writePositions(int id, const void* vertexData) {
+    if (positionVAO == 0) {
+        return;
+    }
+    const MeshRange& range = meshes[id];
+    size_t size = positionStride(vertexLayout);
+    std::vector<unsigned char> positions(range.vertexCount * size);
+    extractPositions(vertexLayout, vertexData, range.vertexCount, positions.data());
+    glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, range.baseVertex * size, positions.size(), positions.data());
+}
+
+void MeshRegistry::attachInstances(unsigned int buffer) {
+    instanceBuffer = buffer;
+    glBindVertexArray(VAO);
+    setupInstanceAttributes(buffer);
+    if (positionVAO != 0) {
+        glBindVertexArray(positionVAO);
+        setupInstanceAttributes(buffer);
+    }
+    glBindVertexArray(0);
+}
+
+void MeshRegistry::attachCasterInstances(unsigned int buffer) {
+    if (casterVAO == 0) {
+        glGenVertexArrays(1, &casterVAO);
+    }
+    glBindVertexArray(casterVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+    setupPositionAttribute(vertexLayout);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    setupInstanceAttributes(buffer);
+    glBindVertexArray(0);
+}
+
+DrawElementsIndirectCommand MeshRegistry::command(int id, unsigned int instanceCount, unsigned int baseInstance, unsigned int lod) const {
+    const MeshRange* range = &meshes[id];
+    if (range->residentLod >= range->lods.size()) {
+        if (range->placeholder < 0) {
+            return DrawElementsIndirectCommand{ 0, instanceCount, 0, 0, baseInstance };
+        }
+        range = &meshes[range->placeholder];
+        lod = 0;
+    }
+    lod = std::min(std::max(lod, range->residentLod), static_cast<unsigned int>(range->lods.size()) - 1);
+    const MeshLod& level = range->lods[lod];
+    return DrawElementsIndirectCommand{ level.indexCount, instanceCount, range->firstIndex + level.firstIndex, range->baseVertex, baseInstance };
+}
+
+void MeshRegistry::bind() const {
+    glBindVertexArray(VAO);
+}
+
+void MeshRegistry::bindPositions() const {
+    glBindVertexArray(positionVAO);
+}
+
+void MeshRegistry::bindCasters() const {
+    glBindVertexArray(casterVAO);
+}
+
+static const void* indexOffset(unsigned int firstIndex) {
+    return reinterpret_cast<const void*>(static_cast<size_t>(firstIndex) * sizeof(unsigned int));
+}
+
+void MeshRegistry::draw(int id, unsigned int lod) const {
+    DrawElementsIndirectCommand level = command(id, 1, 0, lod);
+    if (level.count == 0) {
+        return;
+    }
+    glDrawElementsBaseVertex(GL_TRIANGLES, level.count, GL_UNSIGNED_INT, indexOffset(level.firstIndex), level.baseVertex);
+}
+
+void MeshRegistry::drawInstanced(int id, unsigned int instanceCount, unsigned int baseInstance, unsigned int lod) const {
+    DrawElementsIndirectCommand level = command(id, instanceCount, baseInstance, lod);
+    if (level.count == 0) {
+        return;
+    }
+    if (GLAD_GL_VERSION_4_2) {
+        glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, level.count, GL_UNSIGNED_INT,
+            indexOffset(level.firstIndex), instanceCount, level.baseVertex, baseInstance);
+        return;
+    }
+    // 3.3 has no baseInstance; start the instance attributes at it instead.
+    // Culling needs 4.3, so there every VAO reads the same instance buffer.
+    setupInstanceAttributes(instanceBuffer, baseInstance);
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, level.count, GL_UNSIGNED_INT,
+        indexOffset(level.firstIndex), instanceCount, level.baseVertex);
+}
+
+void MeshRegistry::drawIndirect(size_t commandCount) const {
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(commandCount), 0);
+}
+
+void MeshRegistry::drawIndirectCount(size_t maxCommandCount) const {
+    glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, static_cast<GLsizei>(maxCommandCount), 0);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "gpu_mesh.h"
+
+#include <cstddef>
+#include <vector>
+
+// Layout of one record in a GL_DRAW_INDIRECT_BUFFER, as glMultiDrawElementsIndirect reads it
+struct DrawElementsIndirectCommand {
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int baseInstance;
+};
+
+// Where one mesh lives inside the registry's shared buffers
+struct MeshRange {
+    unsigned int firstIndex = 0;
+    unsigned int indexCount = 0;
+    int baseVertex = 0;
+    unsigned int vertexCount = 0;
+    Bounds bounds;
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+    // Relative to firstIndex; level 0 is the full mesh
+    std::vector<MeshLod> lods;
+    // Relative to firstIndex
+    std::vector<Meshlet> meshlets;
+    // Finest level whose indices are on the GPU; lods.size() until the vertices
+    // and the coarsest level have streamed in
+    unsigned int residentLod = 0;
+    // Drawn instead while nothing is resident; -1 draws nothing
+    int placeholder = -1;
+};
+
+// Sub-allocates every mesh of one vertex layout into a single vertex buffer and
+// a single index buffer behind one VAO, so any number of meshes draw without
+// rebinding and a whole scene can go out as one glMultiDrawElementsIndirect.
+// Indices stay mesh-relative and are offset by baseVertex at draw time.
+class MeshRegistry {
+public:
+    // Reserves room up front; add() grows both buffers when it runs out
+    void create(VertexLayout layout, size_t vertexCapacity = 64 * 1024, size_t indexCapacity = 256 * 1024);
+    void destroy();
+
+    // Keeps a second, position-only copy of every vertex behind a VAO of its
+    // own, so depth-only passes do not fetch normals and texture coordinates.
+    // Call before adding meshes.
+    void enablePositionStream();
+    // Fills the position stream of mesh `id` from its packed vertices (add()
+    // does this itself; MeshStreamer calls it once the vertices are in)
+    void writePositions(int id, const void* vertexData);
+
+    // Copies the view into the shared buffers and returns its mesh id, or -1 if
+    // the view was packed with a different layout
+    int add(const MeshView& view);
+    // Same, but only claims the space; nothing of the mesh is resident until the
+    // data is copied in and setResidentLod() is called (see MeshStreamer)
+    int allocate(const MeshView& view);
+    void setResidentLod(int id, unsigned int lod) { meshes[id].residentLod = lod; }
+    void setPlaceholder(int id, int placeholder) { meshes[id].placeholder = placeholder; }
+
+    const MeshRange& mesh(int id) const { return meshes[id]; }
+    size_t meshCount() const { return meshes.size(); }
+    VertexLayout layout() const { return vertexLayout; }
+    unsigned int vertexBuffer() const { return VBO; }
+    unsigned int indexBuffer() const { return EBO; }
+    // GPU bytes of mesh `id` across the vertex, index and position buffers,
+    // and of all three buffers as allocated, including the room not yet used
+    size_t meshBytes(int id) const;
+    size_t allocatedBytes() const;
+
+    // Adds the per-instance attributes of `buffer` to the shared VAOs
+    void attachInstances(unsigned int buffer);
+    // A third VAO over the position stream with the instances of `buffer`, for
+    // passes that must see every instance while the others read the culled
+    // ones (shadow casters). Needs the position stream.
+    void attachCasterInstances(unsigned int buffer);
+
+    // Levels that have not streamed in yet resolve to the finest resident one,
+    // or to the placeholder; with neither the command draws nothing
+    DrawElementsIndirectCommand command(int id, unsigned int instanceCount, unsigned int baseInstance, unsigned int lod = 0) const;
+
+    // Binds the shared VAO; the draw calls below expect it or the
+    // position-only one to be bound
+    void bind() const;
+    void bindPositions() const;
+    void bindCasters() const;
+    void draw(int id, unsigned int lod = 0) const;
+    void drawInstanced(int id, unsigned int instanceCount, unsigned int baseInstance, unsigned int lod = 0) const;
+    // One glMultiDrawElementsIndirect over `commandCount` records of the bound
+    // GL_DRAW_INDIRECT_BUFFER (GL 4.3)
+    void drawIndirect(size_t commandCount) const;
+    // Same, with the count read from offset 0 of the bound GL_PARAMETER_BUFFER
+    // and capped at `maxCommandCount` (GL 4.6)
+    void drawIndirectCount(size_t maxCommandCount) const;
+
+private:
+    void reserve(size_t vertices, size_t indices);
+
+    VertexLayout vertexLayout = VertexLayout::Float;
+    unsigned int stride = 0;
+    unsigned int VAO = 0;
+    unsigned int VBO = 0;
+    unsigned int EBO = 0;
+    unsigned int positionVAO = 0;
+    unsigned int positionVBO = 0;
+    unsigned int casterVAO = 0;
+    unsigned int instanceBuffer = 0;
+    size_t vertexCapacity = 0;
+    size_t positionCapacity = 0;
+    size_t indexCapacity = 0;
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    std::vector<MeshRange> meshes;
+};
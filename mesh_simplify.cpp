@@ -0,0 +1,306 @@
+#include "mesh_simplify.h"
+#include "mesh_optimize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+
+// Sum of squared distances to a set of planes, as the upper triangle of a
+// symmetric 4x4 matrix. Doubles, because costs of nearly flat regions cancel.
+struct Quadric {
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+    double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+    double a22 = 0.0, a23 = 0.0;
+    double a33 = 0.0;
+
+    void addPlane(double a, double b, double c, double d, double weight) {
+        a00 += weight * a * a; a01 += weight * a * b; a02 += weight * a * c; a03 += weight * a * d;
+        a11 += weight * b * b; a12 += weight * b * c; a13 += weight * b * d;
+        a22 += weight * c * c; a23 += weight * c * d;
+        a33 += weight * d * d;
+    }
+
+    void add(const Quadric& q) {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+        a11 += q.a11; a12 += q.a12; a13 += q.a13;
+        a22 += q.a22; a23 += q.a23;
+        a33 += q.a33;
+    }
+
+    double evaluate(const glm::vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double result = a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x +
+                        a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y +
+                        a22 * z * z + 2.0 * a23 * z + a33;
+        return std::max(result, 0.0);
+    }
+};
+
+// Moving `from` onto `to`; stale once either vertex has changed since it was queued
+struct Collapse {
+    double cost;
+    unsigned int from, to;
+    unsigned int fromVersion, toVersion;
+
+    bool operator>(const Collapse& other) const { return cost > other.cost; }
+};
+
+// Open borders get a plane through the edge, perpendicular to its triangle, so
+// they erode far slower than the interior
+static const double kBorderWeight = 10.0;
+
+// Collapses that turn a neighbouring triangle by more than ~75 degrees are
+// refused; this also rules out flips
+static const float kMinNormalCosine = 0.25f;
+
+struct PositionKey {
+    uint32_t x, y, z;
+
+    bool operator==(const PositionKey& other) const {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+
+struct PositionKeyHash {
+    size_t operator()(const PositionKey& key) const {
+        uint64_t h = key.x * 0x9E3779B97F4A7C15ull;
+        h ^= key.y * 0xC2B2AE3D27D4EB4Full + (h >> 31);
+        h ^= key.z * 0x165667B19E3779F9ull + (h >> 29);
+        return static_cast<size_t>(h);
+    }
+};
+
+static PositionKey positionKey(const glm::vec3& p) {
+    PositionKey key;
+    std::memcpy(&key.x, &p.x, 4);
+    std::memcpy(&key.y, &p.y, 4);
+    std::memcpy(&key.z, &p.z, 4);
+    return key;
+}
+
+static glm::vec3 triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    return glm::cross(b - a, c - a);
+}
+
+std::vector<unsigned int> simplifyMesh(const std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices,
+                                       size_t targetIndexCount, float& error) {
+    error = 0.0f;
+    size_t triangleCount = indices.size() / 3;
+
+    // Weld the referenced vertices by position; remember the corners of each
+    // position so seams can be re-split on output
+    std::unordered_map<PositionKey, unsigned int, PositionKeyHash> positionIds;
+    std::vector<unsigned int> vertexPosition(vertices.size(), ~0u);
+    std::vector<glm::vec3> positions;
+    for (unsigned int index : indices) {
+        if (vertexPosition[index] != ~0u) continue;
+        auto inserted = positionIds.emplace(positionKey(vertices[index].position), static_cast<unsigned int>(positions.size()));
+        if (inserted.second) positions.push_back(vertices[index].position);
+        vertexPosition[index] = inserted.first->second;
+    }
+    size_t positionCount = positions.size();
+    std::vector<std::vector<unsigned int>> positionVertices(positionCount);
+    for (size_t v = 0; v < vertices.size(); v++) {
+        if (vertexPosition[v] != ~0u) positionVertices[vertexPosition[v]].push_back(static_cast<unsigned int>(v));
+    }
+
+    std::vector<unsigned int> triangles(indices.size());
+    for (size_t i = 0; i < indices.size(); i++) triangles[i] = vertexPosition[indices[i]];
+    std::vector<bool> removed(triangleCount, false);
+    size_t liveTriangles = 0;
+    for (size_t t = 0; t < triangleCount; t++) {
+        const unsigned int* p = &triangles[t * 3];
+        removed[t] = p[0] == p[1] || p[1] == p[2] || p[2] == p[0];
+        if (!removed[t]) liveTriangles++;
+    }
+
+    // Plane quadrics of the faces, plus border planes for edges used only once
+    std::vector<Quadric> quadrics(positionCount);
+    std::vector<std::vector<unsigned int>> positionTriangles(positionCount);
+    std::unordered_map<uint64_t, unsigned int> edgeUses;
+    for (size_t t = 0; t < triangleCount; t++) {
+        if (removed[t]) continue;
+        const unsigned int* p = &triangles[t * 3];
+        glm::vec3 normal = triangleNormal(positions[p[0]], positions[p[1]], positions[p[2]]);
+        float length = glm::length(normal);
+        for (int k = 0; k < 3; k++) {
+            positionTriangles[p[k]].push_back(static_cast<unsigned int>(t));
+            uint64_t a = std::min(p[k], p[(k + 1) % 3]), b = std::max(p[k], p[(k + 1) % 3]);
+            edgeUses[(a << 32) | b]++;
+        }
+        if (length == 0.0f) continue;
+        normal /= length;
+        double d = -glm::dot(normal, positions[p[0]]);
+        for (int k = 0; k < 3; k++) quadrics[p[k]].addPlane(normal.x, normal.y, normal.z, d, 1.0);
+    }
+    for (size_t t = 0; t < triangleCount; t++) {
+        if (removed[t]) continue;
+        const unsigned int* p = &triangles[t * 3];
+        glm::vec3 normal = triangleNormal(positions[p[0]], positions[p[1]], positions[p[2]]);
+        for (int k = 0; k < 3; k++) {
+            unsigned int a = p[k], b = p[(k + 1) % 3];
+            uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+            if (edgeUses[key] != 1) continue;
+            glm::vec3 border = glm::cross(positions[b] - positions[a], normal);
+            float length = glm::length(border);
+            if (length == 0.0f) continue;
+            border /= length;
+            double d = -glm::dot(border, positions[a]);
+            quadrics[a].addPlane(border.x, border.y, border.z, d, kBorderWeight);
+            quadrics[b].addPlane(border.x, border.y, border.z, d, kBorderWeight);
+        }
+    }
+
+    std::vector<unsigned int> versions(positionCount, 0);
+    std::vector<bool> alive(positionCount, true);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+
+    auto collapseCost = [&](unsigned int from, unsigned int to) {
+        Quadric q = quadrics[from];
+        q.add(quadrics[to]);
+        return q.evaluate(positions[to]);
+    };
+    // Queues the cheaper direction of edge a-b
+    auto pushEdge = [&](unsigned int a, unsigned int b) {
+        double ab = collapseCost(a, b), ba = collapseCost(b, a);
+        if (ba < ab) std::swap(a, b);
+        queue.push(Collapse{ std::min(ab, ba), a, b, versions[a], versions[b] });
+    };
+
+    for (size_t t = 0; t < triangleCount; t++) {
+        if (removed[t]) continue;
+        const unsigned int* p = &triangles[t * 3];
+        for (int k = 0; k < 3; k++) {
+            // Interior edges are seen from both sides; queue them once
+            if (p[k] < p[(k + 1) % 3]) pushEdge(p[k], p[(k + 1) % 3]);
+        }
+    }
+
+    size_t targetTriangles = targetIndexCount / 3;
+    double maxCost = 0.0;
+    std::vector<unsigned int> neighbours;
+    while (liveTriangles > targetTriangles && !queue.empty()) {
+        Collapse collapse = queue.top();
+        queue.pop();
+        unsigned int from = collapse.from, to = collapse.to;
+        if (!alive[from] || !alive[to] || versions[from] != collapse.fromVersion || versions[to] != collapse.toVersion) {
+            continue;
+        }
+
+        // Every triangle that survives the collapse must keep roughly its facing
+        bool valid = true;
+        for (unsigned int t : positionTriangles[from]) {
+            if (removed[t]) continue;
+            const unsigned int* p = &triangles[t * 3];
+            if (p[0] == to || p[1] == to || p[2] == to) continue;
+            glm::vec3 corners[3], moved[3];
+            for (int k = 0; k < 3; k++) {
+                corners[k] = positions[p[k]];
+                moved[k] = p[k] == from ? positions[to] : corners[k];
+            }
+            glm::vec3 before = triangleNormal(corners[0], corners[1], corners[2]);
+            glm::vec3 after = triangleNormal(moved[0], moved[1], moved[2]);
+            if (glm::dot(before, after) < kMinNormalCosine * glm::length(before) * glm::length(after)) {
+                valid = false;
+                break;
+            }
+        }
+        if (!valid) {
+            continue;
+        }
+
+        maxCost = std::max(maxCost, collapse.cost);
+        quadrics[to].add(quadrics[from]);
+        alive[from] = false;
+        versions[to]++;
+        for (unsigned int t : positionTriangles[from]) {
+            if (removed[t]) continue;
+            unsigned int* p = &triangles[t * 3];
+            if (p[0] == to || p[1] == to || p[2] == to) {
+                removed[t] = true;
+                liveTriangles--;
+                continue;
+            }
+            for (int k = 0; k < 3; k++) {
+                if (p[k] == from) p[k] = to;
+            }
+            positionTriangles[to].push_back(t);
+        }
+        positionTriangles[from].clear();
+
+        // Drop dead triangles from the merged vertex and requeue all its edges
+        std::vector<unsigned int>& around = positionTriangles[to];
+        around.erase(std::remove_if(around.begin(), around.end(), [&](unsigned int t) { return removed[t]; }), around.end());
+        neighbours.clear();
+        for (unsigned int t : around) {
+            for (int k = 0; k < 3; k++) {
+                if (triangles[t * 3 + k] != to) neighbours.push_back(triangles[t * 3 + k]);
+            }
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for (unsigned int neighbour : neighbours) pushEdge(to, neighbour);
+    }
+
+    // Back from positions to vertices: a corner that did not move keeps its
+    // vertex, one that did takes the best-matching vertex at its new position
+    std::vector<unsigned int> output;
+    output.reserve(liveTriangles * 3);
+    for (size_t t = 0; t < triangleCount; t++) {
+        if (removed[t]) continue;
+        for (int k = 0; k < 3; k++) {
+            unsigned int vertex = indices[t * 3 + k];
+            unsigned int position = triangles[t * 3 + k];
+            if (vertexPosition[vertex] != position) {
+                const glm::vec3& normal = vertices[vertex].normal;
+                unsigned int best = positionVertices[position][0];
+                float bestDot = glm::dot(vertices[best].normal, normal);
+                for (unsigned int candidate : positionVertices[position]) {
+                    float d = glm::dot(vertices[candidate].normal, normal);
+                    if (d > bestDot) {
+                        bestDot = d;
+                        best = candidate;
+                    }
+                }
+                vertex = best;
+            }
+            output.push_back(vertex);
+        }
+    }
+
+    error = static_cast<float>(std::sqrt(maxCost));
+    return output;
+}
+
+// Below this a level is not worth its draw-range bookkeeping
+static const size_t kMinLodTriangles = 64;
+
+void buildLodChain(Mesh& mesh) {
+    mesh.lods.clear();
+    mesh.lods.push_back(MeshLod{ 0, static_cast<unsigned int>(mesh.indices.size()), 0.0f });
+
+    std::vector<unsigned int> current = mesh.indices;
+    float error = 0.0f;
+    while (mesh.lods.size() < kMaxLods) {
+        size_t target = current.size() / 6 * 3;
+        if (target / 3 < kMinLodTriangles) {
+            break;
+        }
+        float levelError = 0.0f;
+        std::vector<unsigned int> next = simplifyMesh(current, mesh.vertices, target, levelError);
+        // Locked by borders or refused flips; a near copy would only cost memory
+        if (next.empty() || next.size() * 4 > current.size() * 3) {
+            break;
+        }
+        optimizeVertexCache(next, mesh.vertices.size());
+
+        // Each level is measured against the previous one, so errors add up
+        error += levelError;
+        mesh.lods.push_back(MeshLod{ static_cast<unsigned int>(mesh.indices.size()), static_cast<unsigned int>(next.size()), error });
+        mesh.indices.insert(mesh.indices.end(), next.begin(), next.end());
+        current.swap(next);
+    }
+}
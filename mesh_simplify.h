@@ -0,0 +1,21 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <vector>
+
+// Quadric error metric simplification (Garland & Heckbert) by half-edge
+// collapse: vertices only ever move onto existing vertices, so every level keeps
+// indexing the original vertex buffer. Collapses run in position space, so
+// corners split by normal or UV seams collapse together; each output corner
+// then takes the vertex at its new position whose normal is closest to the one
+// it had. Returns the new index buffer and sets `error` to a conservative bound
+// on the object-space distance from the input surface.
+std::vector<unsigned int> simplifyMesh(const std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices,
+                                       size_t targetIndexCount, float& error);
+
+// Appends up to kMaxLods - 1 coarser levels, each about half the triangles of
+// the previous one, to mesh.indices and records every level in mesh.lods. Each
+// level is simplified from the previous one and cache-optimized on its own.
+// Stops early once a level no longer shrinks meaningfully.
+void buildLodChain(Mesh& mesh);
@@ -0,0 +1,101 @@
+#include "mesh_streamer.h"
+#include "vertex_format.h"
+
+#include <algorithm>
+
+void MeshStreamer::create(size_t bytesPerFrame) {
+    ring.create(bytesPerFrame);
+}
+
+void MeshStreamer::destroy() {
+    ring.destroy();
+    pieces.clear();
+}
+
+int MeshStreamer::add(MeshRegistry& registry, const MeshView& view) {
+    int id = registry.allocate(view);
+    if (id < 0) {
+        return -1;
+    }
+    const MeshRange& range = registry.mesh(id);
+    const unsigned char* indices = reinterpret_cast<const unsigned char*>(view.indexData);
+    pieces.push_back(Piece{ id, kVertexData, range.baseVertex * static_cast<size_t>(view.stride),
+                            static_cast<const unsigned char*>(view.vertexData), view.vertexCount * view.stride });
+    for (size_t level = view.lods.size(); level-- > 0;) {
+        const MeshLod& lod = view.lods[level];
+        pieces.push_back(Piece{ id, static_cast<unsigned int>(level), (range.firstIndex + lod.firstIndex) * sizeof(unsigned int),
+                                indices + lod.firstIndex * sizeof(unsigned int), lod.indexCount * sizeof(unsigned int) });
+    }
+    return id;
+}
+
+bool MeshStreamer::update(MeshRegistry& registry) {
+    if (pieces.empty()) {
+        return false;
+    }
+    bool changed = false;
+    ring.beginFrame();
+    while (!pieces.empty() && ring.available() > 0) {
+        Piece& piece = pieces.front();
+        size_t size = std::min(piece.size, ring.available());
+        unsigned int buffer = piece.level == kVertexData ? registry.vertexBuffer() : registry.indexBuffer();
+        if (size > 0) {
+            ring.copy(buffer, piece.offset, piece.data, size);
+        }
+        piece.offset += size;
+        piece.data += size;
+        piece.size -= size;
+        if (piece.size == 0) {
+            if (piece.level == kVertexData) {
+                // `data` has advanced over the whole vertex range by now
+                const MeshRange& range = registry.mesh(piece.mesh);
+                registry.writePositions(piece.mesh, piece.data - range.vertexCount * static_cast<size_t>(vertexStride(registry.layout())));
+            }
+            else {
+                registry.setResidentLod(piece.mesh, piece.level);
+                changed = true;
+            }
+            pieces.pop_front();
+        }
+    }
+    ring.endFrame();
+    return changed;
+}
+
+size_t MeshStreamer::pendingBytes() const {
+    size_t bytes = 0;
+    for (const Piece& piece : pieces) bytes += piece.size;
+    return bytes;
+}
+
+int addPlaceholder(MeshRegistry& registry, int id) {
+    const Bounds& bounds = registry.mesh(id).bounds;
+    Mesh box;
+    box.bounds = bounds;
+    // Four corners per face so each face keeps a flat normal
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = 0; side < 2; side++) {
+            glm::vec3 normal(0.0f);
+            normal[axis] = side ? 1.0f : -1.0f;
+            int u = (axis + 1) % 3, v = (axis + 2) % 3;
+            unsigned int first = static_cast<unsigned int>(box.vertices.size());
+            for (int corner = 0; corner < 4; corner++) {
+                glm::vec3 position;
+                position[axis] = side ? bounds.max[axis] : bounds.min[axis];
+                position[u] = (corner == 1 || corner == 2) ? bounds.max[u] : bounds.min[u];
+                position[v] = corner >= 2 ? bounds.max[v] : bounds.min[v];
+                box.vertices.push_back(Vertex{ position, normal, glm::vec2(0.0f) });
+            }
+            // Counter-clockwise seen from outside
+            unsigned int a = first, b = first + 1, c = first + 2, d = first + 3;
+            if (side) box.indices.insert(box.indices.end(), { a, b, c, a, c, d });
+            else box.indices.insert(box.indices.end(), { a, c, b, a, d, c });
+        }
+    }
+    PackedVertices packed = packVertices(box, registry.layout());
+    int placeholder = registry.add(makeMeshView(box, packed));
+    if (placeholder >= 0) {
+        registry.setPlaceholder(id, placeholder);
+    }
+    return placeholder;
+}
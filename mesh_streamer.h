@@ -0,0 +1,46 @@
+#pragma once
+
+#include "mesh_registry.h"
+#include "staging_ring.h"
+
+#include <deque>
+
+// Streams meshes into the registry a budgeted slice per frame, so a large scene
+// arrives without a long stall. Each mesh sends its vertices first, then its
+// index levels from coarsest to finest; a level becomes drawable (see
+// MeshRange::residentLod) as soon as its last slice has been copied in.
+class MeshStreamer {
+public:
+    void create(size_t bytesPerFrame);
+    void destroy();
+
+    // Claims room for `view` in the registry and queues its data, which must stay
+    // valid until idle(). Returns the mesh id, or -1 as MeshRegistry::add does.
+    int add(MeshRegistry& registry, const MeshView& view);
+
+    // Copies up to one frame's budget; returns true when any mesh gained a level
+    bool update(MeshRegistry& registry);
+
+    bool idle() const { return pieces.empty(); }
+    size_t pendingBytes() const;
+
+private:
+    static constexpr unsigned int kVertexData = ~0u;
+
+    // One buffer range to fill; `level` is the LOD it completes, or kVertexData
+    struct Piece {
+        int mesh;
+        unsigned int level;
+        size_t offset;
+        const unsigned char* data;
+        size_t size;
+    };
+
+    StagingRing ring;
+    std::deque<Piece> pieces;
+};
+
+// Registers a box over the bounds of mesh `id`, packed with the same position
+// dequantization so it can be drawn with that mesh's instances, and makes it
+// the mesh's placeholder. Returns the box's own id.
+int addPlaceholder(MeshRegistry& registry, int id);
@@ -0,0 +1,99 @@
+#include "meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Normal cones whose triangles spread over a hemisphere or more cannot cull
+static const float kNoCone = 2.0f;
+
+static void computeMeshletBounds(const Mesh& mesh, Meshlet& meshlet) {
+    const unsigned int* indices = &mesh.indices[meshlet.firstIndex];
+
+    glm::vec3 min = mesh.vertices[indices[0]].position, max = min;
+    for (unsigned int i = 0; i < meshlet.indexCount; i++) {
+        min = glm::min(min, mesh.vertices[indices[i]].position);
+        max = glm::max(max, mesh.vertices[indices[i]].position);
+    }
+    glm::vec3 center = (min + max) * 0.5f;
+    float radiusSquared = 0.0f;
+    for (unsigned int i = 0; i < meshlet.indexCount; i++) {
+        glm::vec3 d = mesh.vertices[indices[i]].position - center;
+        radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+    }
+    meshlet.sphere = glm::vec4(center, std::sqrt(radiusSquared));
+
+    // Cone axis is the mean face normal; its half-angle reaches the face
+    // normal furthest from it
+    std::vector<glm::vec3> normals;
+    glm::vec3 axis(0.0f);
+    for (unsigned int i = 0; i < meshlet.indexCount; i += 3) {
+        const glm::vec3& a = mesh.vertices[indices[i]].position;
+        const glm::vec3& b = mesh.vertices[indices[i + 1]].position;
+        const glm::vec3& c = mesh.vertices[indices[i + 2]].position;
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        if (length == 0.0f) continue;
+        normals.push_back(normal / length);
+        axis += normals.back();
+    }
+    float axisLength = glm::length(axis);
+    if (normals.empty() || axisLength == 0.0f) {
+        meshlet.cone = glm::vec4(0.0f, 0.0f, 1.0f, kNoCone);
+        return;
+    }
+    axis /= axisLength;
+    float minDot = 1.0f;
+    for (const glm::vec3& normal : normals) {
+        minDot = std::min(minDot, glm::dot(axis, normal));
+    }
+    float sine = minDot > 0.0f ? std::sqrt(std::max(0.0f, 1.0f - minDot * minDot)) : kNoCone;
+    meshlet.cone = glm::vec4(axis, sine);
+}
+
+std::vector<Meshlet> buildMeshlets(const Mesh& mesh) {
+    std::vector<Meshlet> meshlets;
+    size_t levelCount = mesh.lods.empty() ? mesh.indices.size() : mesh.lods[0].indexCount;
+    if (levelCount == 0) {
+        return meshlets;
+    }
+
+    // stamp[v] is the meshlet that last counted v, so membership is O(1)
+    std::vector<unsigned int> stamp(mesh.vertices.size(), ~0u);
+    Meshlet current = {};
+    unsigned int id = 0;
+
+    auto close = [&]() {
+        computeMeshletBounds(mesh, current);
+        meshlets.push_back(current);
+        unsigned int next = current.firstIndex + current.indexCount;
+        current = {};
+        current.firstIndex = next;
+        id++;
+    };
+
+    // Corners of triangle i not yet in the current meshlet, repeats counted once
+    auto newVertices = [&](size_t i) {
+        const unsigned int* t = &mesh.indices[i];
+        unsigned int count = 0;
+        for (int k = 0; k < 3; k++) {
+            bool repeated = (k > 0 && t[k] == t[0]) || (k > 1 && t[k] == t[1]);
+            if (stamp[t[k]] != id && !repeated) count++;
+        }
+        return count;
+    };
+
+    for (size_t i = 0; i < levelCount; i += 3) {
+        unsigned int added = newVertices(i);
+        if (current.vertexCount + added > kMeshletMaxVertices || current.indexCount / 3 >= kMeshletMaxTriangles) {
+            close();
+            added = newVertices(i);
+        }
+        for (int k = 0; k < 3; k++) stamp[mesh.indices[i + k]] = id;
+        current.vertexCount += added;
+        current.indexCount += 3;
+    }
+    if (current.indexCount > 0) {
+        close();
+    }
+    return meshlets;
+}
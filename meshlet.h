@@ -0,0 +1,14 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <vector>
+
+const unsigned int kMeshletMaxVertices = 64;
+const unsigned int kMeshletMaxTriangles = 124;
+
+// Splits level 0 of a cache-optimized index buffer into meshlets by walking it
+// in order and closing a meshlet as soon as the next triangle would exceed
+// either limit. The Forsyth order already keeps neighbouring triangles
+// adjacent, so meshlets come out compact without moving any indices.
+std::vector<Meshlet> buildMeshlets(const Mesh& mesh);
@@ -0,0 +1,100 @@
+#include "meshlet_culler.h"
+#include "shaders.h"
+
+#include <glad/glad.h>
+
+// std430 mirror of MeshletMesh in the compute shader
+struct MeshletMesh {
+    glm::vec4 sphere;
+    unsigned int firstMeshlet;
+    unsigned int meshletCount;
+    int baseVertex;
+    unsigned int firstIndex;
+};
+
+// Largest workgroup count every implementation accepts in one dimension
+static const unsigned int kMaxGroupsX = 65535;
+
+static unsigned int createBuffer(GLenum target, size_t size, const void* data, GLenum usage) {
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    glBufferData(target, size, data, usage);
+    return buffer;
+}
+
+void MeshletCuller::create(ProgramCache& programs, const MeshRegistry& registry, unsigned int input,
+                           const std::vector<DrawElementsIndirectCommand>& records) {
+    program = programs.program(programs.requestCompute(meshletCullComputeShaderSource));
+    bindUniformBlock(program, "FrameData", kFrameDataBinding);
+    bindUniformBlock(program, "ObjectData", kObjectDataBinding);
+    instanceCountLocation = program.location("instanceCount");
+    instanceBuffer = input;
+
+    std::vector<MeshletMesh> meshes(records.size());
+    std::vector<Meshlet> meshlets;
+    std::vector<unsigned int> instanceMeshes;
+    for (size_t m = 0; m < records.size(); m++) {
+        const MeshRange& range = registry.mesh(static_cast<int>(m));
+        meshes[m] = MeshletMesh{ glm::vec4(range.bounds.center, range.bounds.radius),
+            static_cast<unsigned int>(meshlets.size()), static_cast<unsigned int>(range.meshlets.size()),
+            range.baseVertex, range.firstIndex };
+        meshlets.insert(meshlets.end(), range.meshlets.begin(), range.meshlets.end());
+        instanceMeshes.resize(records[m].baseInstance + records[m].instanceCount, static_cast<unsigned int>(m));
+        maxDraws += static_cast<size_t>(records[m].instanceCount) * range.meshlets.size();
+    }
+    instances = static_cast<unsigned int>(instanceMeshes.size());
+
+    meshBuffer = createBuffer(GL_SHADER_STORAGE_BUFFER, meshes.size() * sizeof(MeshletMesh), meshes.data(), GL_STATIC_DRAW);
+    meshletBuffer = createBuffer(GL_SHADER_STORAGE_BUFFER, meshlets.size() * sizeof(Meshlet), meshlets.data(), GL_STATIC_DRAW);
+    instanceMeshBuffer = createBuffer(GL_SHADER_STORAGE_BUFFER, instanceMeshes.size() * sizeof(unsigned int), instanceMeshes.data(), GL_STATIC_DRAW);
+    commandBuffer = createBuffer(GL_DRAW_INDIRECT_BUFFER, maxDraws * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_COPY);
+    countBuffer = createBuffer(GL_SHADER_STORAGE_BUFFER, sizeof(unsigned int), nullptr, GL_DYNAMIC_COPY);
+}
+
+void MeshletCuller::destroy() {
+    // The program belongs to the ProgramCache
+    program = ShaderProgram();
+    for (unsigned int* buffer : { &commandBuffer, &countBuffer, &meshBuffer, &instanceMeshBuffer, &meshletBuffer }) {
+        glDeleteBuffers(1, buffer);
+    }
+    *this = MeshletCuller();
+}
+
+void MeshletCuller::cull() const {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, countBuffer);
+    glClearBufferData(GL_COPY_WRITE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    // Without a GPU draw count the stale tail must not draw anything
+    if (!GLAD_GL_VERSION_4_6) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, commandBuffer);
+        glClearBufferData(GL_COPY_WRITE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    }
+
+    glUseProgram(program.id);
+    glUniform1ui(instanceCountLocation, instances);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, countBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, meshBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, instanceMeshBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, meshletBuffer);
+    unsigned int groupsX = instances < kMaxGroupsX ? instances : kMaxGroupsX;
+    unsigned int groupsY = (instances + kMaxGroupsX - 1) / kMaxGroupsX;
+    if (groupsX > 0) {
+        glDispatchCompute(groupsX, groupsY, 1);
+    }
+
+    // The commands and their count are read as indirect parameters
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+}
+
+void MeshletCuller::draw(const MeshRegistry& registry) const {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    if (GLAD_GL_VERSION_4_6) {
+        glBindBuffer(GL_PARAMETER_BUFFER, countBuffer);
+        registry.drawIndirectCount(maxDraws);
+    }
+    else {
+        registry.drawIndirect(maxDraws);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "mesh_registry.h"
+#include "program_cache.h"
+
+#include <vector>
+
+// Per-meshlet culling for the indirect path. A compute pass rejects meshlets
+// that are off-screen or whose normal cone faces away from the camera and
+// appends one draw per surviving (instance, meshlet) to an indirect buffer. On
+// 4.6 the number of draws is read from the GPU counter; before that every slot
+// is cleared each frame and the unused ones are empty draws. Needs a 4.3
+// context, and back-face culling enabled for the image to match unculled draws.
+class MeshletCuller {
+public:
+    // `commands` holds one record per registry mesh; instances
+    // [baseInstance, baseInstance + instanceCount) of `instanceBuffer` belong to
+    // it. The draws index that buffer, so it must stay attached to the registry.
+    void create(ProgramCache& programs, const MeshRegistry& registry, unsigned int instanceBuffer,
+                const std::vector<DrawElementsIndirectCommand>& commands);
+    void destroy();
+
+    // Clears last frame's draws and dispatches the cull. FrameData and ObjectData
+    // must be bound, since the camera and shared model matrix come from them.
+    void cull() const;
+
+    // Issues the surviving draws with the registry VAO bound
+    void draw(const MeshRegistry& registry) const;
+
+    size_t meshletCount() const { return maxDraws; }
+
+private:
+    ShaderProgram program;
+    int instanceCountLocation = -1;
+    unsigned int instanceBuffer = 0;
+    unsigned int commandBuffer = 0;
+    unsigned int countBuffer = 0;
+    unsigned int meshBuffer = 0;
+    unsigned int instanceMeshBuffer = 0;
+    unsigned int meshletBuffer = 0;
+    unsigned int instances = 0;
+    size_t maxDraws = 0;
+};
@@ -0,0 +1,607 @@
+#include "obj_loader.h"
+#include "linear_arena.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+
+// Reads the whole file into memory and appends a '\0' so the scanner can look
+// one byte past any token without bounds checks.
+template <typename Buffer>
+static bool readFile(const char* path, Buffer& buffer) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    buffer.resize(static_cast<size_t>(size) + 1);
+    if (size > 0 && !file.read(buffer.data(), size)) {
+        return false;
+    }
+    buffer[static_cast<size_t>(size)] = '\0';
+    return true;
+}
+
+static const char* skipSpaces(const char* p) {
+    while (*p == ' ' || *p == '\t') ++p;
+    return p;
+}
+
+static const char* nextLine(const char* p, const char* end) {
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return eol ? eol + 1 : end;
+}
+
+static bool isLineEnd(char c) {
+    return c == '\n' || c == '\r' || c == '#' || c == '\0';
+}
+
+static const char* parseFloat(const char* p, const char* end, float& value) {
+    p = skipSpaces(p);
+    if (*p == '+') ++p;
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) {
+        value = 0.0f;
+    }
+    return result.ptr;
+}
+
+// The rest of the line, without surrounding blanks or a trailing comment
+static std::string parseName(const char* p) {
+    p = skipSpaces(p);
+    const char* last = p;
+    while (!isLineEnd(*last)) ++last;
+    while (last > p && (last[-1] == ' ' || last[-1] == '\t')) --last;
+    return std::string(p, last);
+}
+
+static const char* parseIndex(const char* p, const char* end, long long& value) {
+    value = 0;
+    std::from_chars_result result = std::from_chars(p, end, value);
+    return result.ptr;
+}
+
+// OBJ indices are 1-based, or negative to count back from the latest record;
+// `defined` is how many records of that kind precede the face. A missing or
+// out-of-range component becomes ~0u.
+static unsigned int resolveIndex(long long index, size_t defined) {
+    if (index > 0) return static_cast<unsigned int>(index - 1);
+    if (index < 0 && static_cast<size_t>(-index) <= defined) return static_cast<unsigned int>(defined + index);
+    return ~0u;
+}
+
+struct RecordCounts {
+    size_t vertices = 0;
+    size_t texCoords = 0;
+    size_t normals = 0;
+    size_t faces = 0;
+};
+
+// One cheap memchr pass over a chunk, with the same record tests parseChunk uses.
+// The prefix sums of these counts give every chunk the global index of its first
+// v/vt/vn record before anything is parsed.
+static RecordCounts countRecords(const char* begin, const char* end) {
+    RecordCounts counted;
+    for (const char* p = begin; p < end; p = nextLine(p, end)) {
+        if (p[0] == 'v' && p[1] == ' ') counted.vertices++;
+        else if (p[0] == 'v' && p[1] == 't' && p[2] == ' ') counted.texCoords++;
+        else if (p[0] == 'v' && p[1] == 'n' && p[2] == ' ') counted.normals++;
+        else if (p[0] == 'f' && p[1] == ' ') counted.faces++;
+    }
+    return counted;
+}
+
+// The 0-based v/vt/vn indices of one face corner; a missing component is ~0u
+struct CornerKey {
+    unsigned int v, vt, vn;
+
+    bool operator==(const CornerKey& other) const {
+        return v == other.v && vt == other.vt && vn == other.vn;
+    }
+};
+
+// Open-addressing hash table from face corners to welded vertex indices. Sized
+// from the vertex count so a typical file never rehashes.
+class CornerTable {
+public:
+    CornerTable(size_t expected, LinearArena& arena) : slots(ArenaAllocator<Slot>(arena)) {
+        size_t capacity = 64;
+        while (capacity < expected * 2) capacity *= 2;
+        slots.assign(capacity, Slot{ {}, EMPTY });
+    }
+
+    // Returns the welded index of `key`, assigning it `next` if it is new
+    unsigned int findOrInsert(const CornerKey& key, unsigned int next) {
+        if ((count + 1) * 10 > slots.size() * 7) grow();
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash(key) & mask;; i = (i + 1) & mask) {
+            if (slots[i].index == EMPTY) {
+                slots[i] = Slot{ key, next };
+                count++;
+                return next;
+            }
+            if (slots[i].key == key) return slots[i].index;
+        }
+    }
+
+private:
+    static constexpr unsigned int EMPTY = ~0u;
+
+    struct Slot {
+        CornerKey key;
+        unsigned int index;
+    };
+
+    static size_t hash(const CornerKey& key) {
+        unsigned long long h = key.v * 0x9E3779B97F4A7C15ull;
+        h ^= (key.vt + 0x7F4A7C15ull) * 0xC2B2AE3D27D4EB4Full;
+        h ^= (key.vn + 0x165667B1ull) * 0x165667B19E3779F9ull;
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+
+    void grow() {
+        ArenaVector<Slot> old(slots.size() * 2, Slot{ {}, EMPTY }, slots.get_allocator());
+        old.swap(slots);
+        count = 0;
+        for (const Slot& slot : old) {
+            if (slot.index != EMPTY) findOrInsert(slot.key, slot.index);
+        }
+    }
+
+    ArenaVector<Slot> slots;
+    size_t count = 0;
+};
+
+template <typename Values>
+static typename Values::value_type lookup(const Values& values, unsigned int index) {
+    return index < values.size() ? values[index] : typename Values::value_type(0.0f);
+}
+
+// Files below this size per thread are not worth splitting
+static const size_t kMinChunkBytes = 1 << 20;
+
+// A line-aligned slice of the file. Each chunk is parsed by its own thread into
+// its own arrays; only the weld of its unique corners is merged serially.
+// The arrays live in the parse's arena and go with it.
+struct ObjChunk {
+    explicit ObjChunk(LinearArena& arena)
+        : corners(ArenaAllocator<CornerKey>(arena)), indices(ArenaAllocator<unsigned int>(arena)),
+          remap(ArenaAllocator<unsigned int>(arena)), triangleUses(ArenaAllocator<int>(arena)) {}
+
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    RecordCounts counts;                 // records in this chunk
+    RecordCounts first;                  // records in all earlier chunks
+    ArenaVector<CornerKey> corners;      // unique corners, in first-use order
+    ArenaVector<unsigned int> indices;   // triangles indexing `corners`
+    ArenaVector<unsigned int> remap;     // corners -> welded mesh vertex
+    unsigned int firstVertex = 0;       // first welded vertex this chunk introduced
+    size_t firstIndex = 0;              // where `indices` go in the mesh
+    std::vector<std::string> libraries;     // mtllib file names
+    std::vector<std::string> materialUses;  // usemtl names, in order
+    // Per triangle, an index into materialUses or -1 before the chunk's first
+    // usemtl; empty when the chunk has none
+    ArenaVector<int> triangleUses;
+    bool missingNormals = false;        // some corner has no usable vn
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    float radiusSquared = 0.0f;
+};
+
+static std::vector<ObjChunk> splitChunks(const char* begin, const char* end, size_t count, LinearArena& arena) {
+    std::vector<ObjChunk> chunks;
+    chunks.reserve(count);
+    size_t size = static_cast<size_t>(end - begin);
+    const char* p = begin;
+    for (size_t i = 0; i < count; i++) {
+        chunks.emplace_back(arena);
+        chunks[i].begin = p;
+        p = i + 1 == count ? end : std::max(p, nextLine(begin + size * (i + 1) / count, end));
+        chunks[i].end = p;
+    }
+    return chunks;
+}
+
+// Runs `task` on every chunk, one thread each
+template <typename Task>
+static void forEachChunk(std::vector<ObjChunk>& chunks, Task task) {
+    if (chunks.size() == 1) {
+        task(chunks[0]);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(chunks.size());
+    for (ObjChunk& chunk : chunks) workers.emplace_back(task, std::ref(chunk));
+    for (std::thread& worker : workers) worker.join();
+}
+
+// Parses the records of one chunk. v/vt/vn go straight into the shared arrays
+// at the chunk's prefix-sum offsets; faces are welded into chunk-local corners.
+static void parseChunk(ObjChunk& chunk, ArenaVector<glm::vec3>& positions,
+                       ArenaVector<glm::vec2>& texCoords, ArenaVector<glm::vec3>& normals, LinearArena& arena) {
+    const char* end = chunk.end;
+    size_t vertexCount = chunk.first.vertices;
+    size_t texCoordCount = chunk.first.texCoords;
+    size_t normalCount = chunk.first.normals;
+
+    chunk.corners.reserve(chunk.counts.vertices);
+    chunk.indices.reserve(chunk.counts.faces * 3);
+    CornerTable corners(chunk.counts.vertices, arena);
+    // Reused for every face so polygon corners never allocate after the first face
+    ArenaVector<unsigned int> faceVerts{ ArenaAllocator<unsigned int>(arena) };
+    faceVerts.reserve(16);
+    int currentUse = -1;
+
+    for (const char* p = chunk.begin; p < end; p = nextLine(p, end)) {
+        if (p[0] == 'v' && p[1] == ' ') {
+            glm::vec3& vertex = positions[vertexCount++];
+            p = parseFloat(p + 2, end, vertex.x);
+            p = parseFloat(p, end, vertex.y);
+            p = parseFloat(p, end, vertex.z);
+        }
+        else if (p[0] == 'v' && p[1] == 't' && p[2] == ' ') {
+            glm::vec2& texCoord = texCoords[texCoordCount++];
+            p = parseFloat(p + 3, end, texCoord.x);
+            p = parseFloat(p, end, texCoord.y);
+        }
+        else if (p[0] == 'v' && p[1] == 'n' && p[2] == ' ') {
+            glm::vec3& normal = normals[normalCount++];
+            p = parseFloat(p + 3, end, normal.x);
+            p = parseFloat(p, end, normal.y);
+            p = parseFloat(p, end, normal.z);
+        }
+        else if (p[0] == 'f' && p[1] == ' ') {
+            faceVerts.clear();
+            p = skipSpaces(p + 2);
+
+            // Corners are v/vt/vn; each unique triple is welded into one Vertex
+            while (!isLineEnd(*p)) {
+                long long v = 0, vt = 0, vn = 0;
+                p = parseIndex(p, end, v);
+                if (*p == '/') {
+                    p = parseIndex(p + 1, end, vt);
+                    if (*p == '/') p = parseIndex(p + 1, end, vn);
+                }
+                while (!isLineEnd(*p) && *p != ' ' && *p != '\t') ++p;
+                p = skipSpaces(p);
+
+                CornerKey key = {
+                    resolveIndex(v, vertexCount),
+                    resolveIndex(vt, texCoordCount),
+                    resolveIndex(vn, normalCount) };
+                unsigned int next = static_cast<unsigned int>(chunk.corners.size());
+                unsigned int index = corners.findOrInsert(key, next);
+                if (index == next) {
+                    chunk.corners.push_back(key);
+                    chunk.missingNormals = chunk.missingNormals || key.vn >= normals.size();
+                }
+                faceVerts.push_back(index);
+            }
+
+            // Triangulate face
+            for (size_t i = 1; i + 1 < faceVerts.size(); i++) {
+                chunk.indices.push_back(faceVerts[0]);
+                chunk.indices.push_back(faceVerts[i]);
+                chunk.indices.push_back(faceVerts[i + 1]);
+            }
+        }
+        else if (std::strncmp(p, "usemtl", 6) == 0 && (p[6] == ' ' || p[6] == '\t')) {
+            chunk.triangleUses.resize(chunk.indices.size() / 3, currentUse);
+            currentUse = static_cast<int>(chunk.materialUses.size());
+            chunk.materialUses.push_back(parseName(p + 6));
+        }
+        else if (std::strncmp(p, "mtllib", 6) == 0 && (p[6] == ' ' || p[6] == '\t')) {
+            chunk.libraries.push_back(parseName(p + 6));
+        }
+    }
+    if (!chunk.materialUses.empty()) {
+        chunk.triangleUses.resize(chunk.indices.size() / 3, currentUse);
+    }
+
+    if (chunk.counts.vertices > 0) {
+        const glm::vec3* first = &positions[chunk.first.vertices];
+        chunk.boundsMin = chunk.boundsMax = first[0];
+        for (size_t i = 0; i < chunk.counts.vertices; i++) {
+            chunk.boundsMin = glm::min(chunk.boundsMin, first[i]);
+            chunk.boundsMax = glm::max(chunk.boundsMax, first[i]);
+        }
+    }
+}
+
+// Smooth normals for the vertices that have none, in one pass over the
+// triangles. `positionOf` maps each such vertex to its OBJ position index and
+// every other vertex to ~0u. Corners that share a position share the normal
+// whatever their texture coordinates, and each face counts by its area times
+// the corner angle, so a split quad or a fan of slivers does not skew it.
+static void generateNormals(Mesh& mesh, const ArenaVector<unsigned int>& positionOf, size_t positionCount, LinearArena& arena) {
+    ArenaVector<glm::vec3> sums(positionCount, glm::vec3(0.0f), ArenaAllocator<glm::vec3>(arena));
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        const unsigned int* corner = &mesh.indices[i];
+        glm::vec3 p[3] = { mesh.vertices[corner[0]].position, mesh.vertices[corner[1]].position, mesh.vertices[corner[2]].position };
+        // Its length is twice the triangle's area
+        glm::vec3 faceNormal = glm::cross(p[1] - p[0], p[2] - p[0]);
+        for (int k = 0; k < 3; k++) {
+            unsigned int position = positionOf[corner[k]];
+            if (position == ~0u) continue;
+            glm::vec3 a = p[(k + 1) % 3] - p[k];
+            glm::vec3 b = p[(k + 2) % 3] - p[k];
+            float lengths = glm::length(a) * glm::length(b);
+            if (lengths <= 0.0f) continue;
+            sums[position] += faceNormal * std::acos(glm::clamp(glm::dot(a, b) / lengths, -1.0f, 1.0f));
+        }
+    }
+    for (size_t v = 0; v < mesh.vertices.size(); v++) {
+        if (positionOf[v] == ~0u) continue;
+        float length = glm::length(sums[positionOf[v]]);
+        mesh.vertices[v].normal = length > 0.0f ? sums[positionOf[v]] / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+}
+
+// Reads the newmtl blocks of an MTL file; only Ka, Kd, Ks and Ns are used
+static bool loadMaterialLibrary(const std::string& path, std::vector<Material>& materials) {
+    std::vector<char> buffer;
+    if (!readFile(path.c_str(), buffer)) {
+        return false;
+    }
+    const char* end = buffer.data() + buffer.size() - 1;
+    Material* material = nullptr;
+    for (const char* p = buffer.data(); p < end; p = nextLine(p, end)) {
+        p = skipSpaces(p);
+        if (std::strncmp(p, "newmtl", 6) == 0 && (p[6] == ' ' || p[6] == '\t')) {
+            materials.emplace_back();
+            material = &materials.back();
+            material->name = parseName(p + 6);
+            continue;
+        }
+        if (!material) continue;
+        glm::vec3* color = nullptr;
+        if (p[0] == 'K' && p[1] == 'a' && p[2] == ' ') color = &material->ambient;
+        else if (p[0] == 'K' && p[1] == 'd' && p[2] == ' ') color = &material->diffuse;
+        else if (p[0] == 'K' && p[1] == 's' && p[2] == ' ') color = &material->specular;
+        else if (p[0] == 'N' && p[1] == 's' && p[2] == ' ') parseFloat(p + 3, end, material->shininess);
+        if (color) {
+            p = parseFloat(p + 3, end, color->x);
+            p = parseFloat(p, end, color->y);
+            parseFloat(p, end, color->z);
+        }
+    }
+    return true;
+}
+
+// Resolves the usemtl names of every chunk to Mesh::materials, in order of first
+// use, and returns the material of every triangle. A chunk's faces before its
+// first usemtl continue the material the previous chunk ended with.
+static ArenaVector<int> resolveMaterials(const char* objPath, const std::vector<ObjChunk>& chunks, Mesh& mesh, LinearArena& arena) {
+    ArenaVector<int> triangleMaterials{ ArenaAllocator<int>(arena) };
+    std::vector<std::string> libraries;
+    bool used = false;
+    for (const ObjChunk& chunk : chunks) {
+        libraries.insert(libraries.end(), chunk.libraries.begin(), chunk.libraries.end());
+        used = used || !chunk.materialUses.empty();
+    }
+    if (!used) {
+        return triangleMaterials;
+    }
+
+    std::unordered_map<std::string, int> byName;
+    int current = -1;
+    for (const ObjChunk& chunk : chunks) {
+        std::vector<int> global(chunk.materialUses.size());
+        for (size_t i = 0; i < chunk.materialUses.size(); i++) {
+            auto inserted = byName.emplace(chunk.materialUses[i], static_cast<int>(mesh.materials.size()));
+            if (inserted.second) {
+                mesh.materials.emplace_back();
+                mesh.materials.back().name = chunk.materialUses[i];
+            }
+            global[i] = inserted.first->second;
+        }
+        size_t triangles = chunk.indices.size() / 3;
+        triangleMaterials.reserve(triangleMaterials.size() + triangles);
+        for (size_t t = 0; t < triangles; t++) {
+            int use = chunk.triangleUses.empty() ? -1 : chunk.triangleUses[t];
+            triangleMaterials.push_back(use < 0 ? current : global[use]);
+        }
+        if (!global.empty()) current = global.back();
+    }
+
+    // Library names are relative to the OBJ; the first definition of a name wins
+    std::vector<Material> defined;
+    std::filesystem::path directory = std::filesystem::path(objPath).parent_path();
+    for (const std::string& library : libraries) {
+        std::string libraryPath = (directory / library).string();
+        mesh.materialLibraries.push_back(libraryPath);
+        if (!loadMaterialLibrary(libraryPath, defined)) {
+            std::cerr << "Failed to open material library: " << libraryPath << std::endl;
+        }
+    }
+    for (Material& material : mesh.materials) {
+        auto found = std::find_if(defined.begin(), defined.end(),
+                                  [&](const Material& candidate) { return candidate.name == material.name; });
+        if (found != defined.end()) {
+            material = *found;
+        }
+        else {
+            std::cerr << objPath << ": material " << material.name << " is not defined, using defaults" << std::endl;
+        }
+    }
+    return triangleMaterials;
+}
+
+// Stable counting sort of the triangles by material, producing one submesh per
+// material in order of first use; faces without a material form their own
+static void groupByMaterial(Mesh& mesh, const ArenaVector<int>& triangleMaterials) {
+    std::vector<size_t> counts(mesh.materials.size() + 1, 0);
+    std::vector<int> order;
+    for (int material : triangleMaterials) {
+        if (counts[material + 1]++ == 0) order.push_back(material);
+    }
+    std::vector<size_t> offsets(counts.size(), 0);
+    size_t offset = 0;
+    for (int material : order) {
+        offsets[material + 1] = offset;
+        mesh.submeshes.push_back(Submesh{ static_cast<unsigned int>(offset * 3),
+                                          static_cast<unsigned int>(counts[material + 1] * 3), material });
+        offset += counts[material + 1];
+    }
+    std::vector<unsigned int> grouped(mesh.indices.size());
+    for (size_t t = 0; t < triangleMaterials.size(); t++) {
+        size_t to = offsets[triangleMaterials[t] + 1]++;
+        std::copy_n(mesh.indices.begin() + t * 3, 3, grouped.begin() + to * 3);
+    }
+    mesh.indices.swap(grouped);
+}
+
+Mesh loadOBJ(const char* path, unsigned int threadCount, size_t* scratchBytes, unsigned int maxThreads) {
+    Mesh mesh;
+    // Everything below but the mesh itself is scratch, freed in one go on return
+    LinearArena arena;
+    ArenaVector<char> buffer{ ArenaAllocator<char>(arena) };
+    if (!readFile(path, buffer)) {
+        std::cerr << "Failed to open OBJ file: " << path << std::endl;
+        return mesh;
+    }
+    const char* begin = buffer.data();
+    const char* end = begin + buffer.size() - 1;
+
+    size_t chunkCount = threadCount;
+    if (chunkCount == 0) {
+        chunkCount = std::min<size_t>(maxThreads ? maxThreads : std::max(std::thread::hardware_concurrency(), 1u),
+                                      static_cast<size_t>(end - begin) / kMinChunkBytes);
+    }
+    std::vector<ObjChunk> chunks = splitChunks(begin, end, std::max<size_t>(chunkCount, 1), arena);
+
+    forEachChunk(chunks, [](ObjChunk& chunk) { chunk.counts = countRecords(chunk.begin, chunk.end); });
+    RecordCounts total;
+    for (ObjChunk& chunk : chunks) {
+        chunk.first = total;
+        total.vertices += chunk.counts.vertices;
+        total.texCoords += chunk.counts.texCoords;
+        total.normals += chunk.counts.normals;
+        total.faces += chunk.counts.faces;
+    }
+
+    ArenaVector<glm::vec3> positions(total.vertices, glm::vec3(0.0f), ArenaAllocator<glm::vec3>(arena));
+    ArenaVector<glm::vec2> texCoords(total.texCoords, glm::vec2(0.0f), ArenaAllocator<glm::vec2>(arena));
+    ArenaVector<glm::vec3> normals(total.normals, glm::vec3(0.0f), ArenaAllocator<glm::vec3>(arena));
+    forEachChunk(chunks, [&](ObjChunk& chunk) { parseChunk(chunk, positions, texCoords, normals, arena); });
+
+    // Weld across chunks in file order. Each chunk lists its corners in
+    // first-use order, so the numbering matches a single pass over the file.
+    CornerTable welded(chunks.size() > 1 ? total.vertices : 0, arena);
+    unsigned int vertexCount = 0;
+    size_t indexCount = 0;
+    for (ObjChunk& chunk : chunks) {
+        chunk.firstVertex = vertexCount;
+        chunk.firstIndex = indexCount;
+        indexCount += chunk.indices.size();
+        chunk.remap.resize(chunk.corners.size());
+        for (size_t i = 0; i < chunk.corners.size(); i++) {
+            unsigned int index = chunks.size() > 1 ? welded.findOrInsert(chunk.corners[i], vertexCount) : vertexCount;
+            if (index == vertexCount) vertexCount++;
+            chunk.remap[i] = index;
+        }
+    }
+
+    if (total.vertices > 0) {
+        bool found = false;
+        for (const ObjChunk& chunk : chunks) {
+            if (chunk.counts.vertices == 0) continue;
+            mesh.bounds.min = found ? glm::min(mesh.bounds.min, chunk.boundsMin) : chunk.boundsMin;
+            mesh.bounds.max = found ? glm::max(mesh.bounds.max, chunk.boundsMax) : chunk.boundsMax;
+            found = true;
+        }
+        // Centred on the box and sized by the farthest vertex, which is tighter
+        // than the half diagonal for round meshes like the teapot
+        mesh.bounds.center = (mesh.bounds.min + mesh.bounds.max) * 0.5f;
+    }
+
+    bool missingNormals = false;
+    for (const ObjChunk& chunk : chunks) missingNormals = missingNormals || chunk.missingNormals;
+    ArenaVector<unsigned int> positionOf(missingNormals ? vertexCount : 0, 0u, ArenaAllocator<unsigned int>(arena));
+
+    mesh.vertices.resize(vertexCount);
+    mesh.indices.resize(indexCount);
+    forEachChunk(chunks, [&](ObjChunk& chunk) {
+        for (size_t i = 0; i < chunk.corners.size(); i++) {
+            unsigned int index = chunk.remap[i];
+            if (index < chunk.firstVertex) continue;
+            const CornerKey& key = chunk.corners[i];
+            mesh.vertices[index] = Vertex{
+                lookup(positions, key.v),
+                lookup(normals, key.vn),
+                lookup(texCoords, key.vt) };
+            if (missingNormals) {
+                positionOf[index] = key.vn >= normals.size() && key.v < positions.size() ? key.v : ~0u;
+            }
+        }
+        unsigned int* out = mesh.indices.data() + chunk.firstIndex;
+        for (size_t i = 0; i < chunk.indices.size(); i++) out[i] = chunk.remap[chunk.indices[i]];
+
+        const glm::vec3* first = positions.data() + chunk.first.vertices;
+        for (size_t i = 0; i < chunk.counts.vertices; i++) {
+            glm::vec3 d = first[i] - mesh.bounds.center;
+            chunk.radiusSquared = glm::max(chunk.radiusSquared, glm::dot(d, d));
+        }
+    });
+
+    float radiusSquared = 0.0f;
+    for (const ObjChunk& chunk : chunks) radiusSquared = glm::max(radiusSquared, chunk.radiusSquared);
+    mesh.bounds.radius = std::sqrt(radiusSquared);
+
+    if (missingNormals) {
+        generateNormals(mesh, positionOf, positions.size(), arena);
+    }
+
+    ArenaVector<int> triangleMaterials = resolveMaterials(path, chunks, mesh, arena);
+    if (!triangleMaterials.empty()) {
+        groupByMaterial(mesh, triangleMaterials);
+    }
+    if (scratchBytes) {
+        *scratchBytes = arena.peakBytes();
+    }
+    return mesh;
+}
+
+Mesh extractSubmesh(const Mesh& mesh, const Submesh& submesh) {
+    Mesh part;
+    part.materialLibraries = mesh.materialLibraries;
+    std::vector<unsigned int> remap(mesh.vertices.size(), ~0u);
+    part.indices.reserve(submesh.indexCount);
+    for (unsigned int i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i++) {
+        unsigned int& index = remap[mesh.indices[i]];
+        if (index == ~0u) {
+            index = static_cast<unsigned int>(part.vertices.size());
+            part.vertices.push_back(mesh.vertices[mesh.indices[i]]);
+        }
+        part.indices.push_back(index);
+    }
+
+    if (!part.vertices.empty()) {
+        part.bounds.min = part.bounds.max = part.vertices[0].position;
+        for (const Vertex& vertex : part.vertices) {
+            part.bounds.min = glm::min(part.bounds.min, vertex.position);
+            part.bounds.max = glm::max(part.bounds.max, vertex.position);
+        }
+        part.bounds.center = (part.bounds.min + part.bounds.max) * 0.5f;
+        float radiusSquared = 0.0f;
+        for (const Vertex& vertex : part.vertices) {
+            glm::vec3 d = vertex.position - part.bounds.center;
+            radiusSquared = glm::max(radiusSquared, glm::dot(d, d));
+        }
+        part.bounds.radius = std::sqrt(radiusSquared);
+    }
+
+    if (submesh.material >= 0) {
+        part.materials.push_back(mesh.materials[submesh.material]);
+        part.submeshes.push_back(Submesh{ 0, submesh.indexCount, 0 });
+    }
+    return part;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "mesh.h"
+
+// Parses a Wavefront OBJ file into a triangulated Mesh. The whole file is read
+// into one buffer and tokenized in place, so no per-line strings are created.
+// Large files are split at line boundaries and parsed on `threadCount` threads
+// (0 picks at least 1 MB per thread, up to `maxThreads` or, when that is 0, one
+// per core); the result does not depend on the thread count. Corners may be v, v/vt, v//vn or v/vt/vn, with negative
+// indices counting back; vertices without a normal get a smooth one from the
+// faces around their position. Materials named by usemtl are read from the mtllib files
+// next to the OBJ, and the triangles are grouped into one submesh each. The file
+// and every scratch array come from one arena released before returning; its
+// high-water mark goes to `scratchBytes` when given.
+Mesh loadOBJ(const char* path, unsigned int threadCount = 0, size_t* scratchBytes = nullptr, unsigned int maxThreads = 0);
+
+// Copies one submesh into a mesh of its own, keeping only the vertices it uses
+// and with bounds of its own. Its material, if any, becomes its only submesh.
+Mesh extractSubmesh(const Mesh& mesh, const Submesh& submesh);
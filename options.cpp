@@ -0,0 +1,306 @@
+#include "options.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static bool parseNonNegative(const char* text, float& value) {
+    char* end = nullptr;
+    float parsed = std::strtof(text, &end);
+    if (end == text || *end != '\0' || !(parsed >= 0.0f)) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+static bool parseCount(const char* text, unsigned int& value) {
+    char* end = nullptr;
+    unsigned long parsed = std::strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || parsed == 0) {
+        return false;
+    }
+    value = static_cast<unsigned int>(parsed);
+    return true;
+}
+
+// "1920x1080"
+static bool parseResolution(const char* text, unsigned int& width, unsigned int& height) {
+    char* end = nullptr;
+    unsigned long w = std::strtoul(text, &end, 10);
+    if (end == text || (*end != 'x' && *end != 'X')) {
+        return false;
+    }
+    const char* rest = end + 1;
+    unsigned long h = std::strtoul(rest, &end, 10);
+    if (end == rest || *end != '\0' || w == 0 || h == 0 || w > 16384 || h > 16384) {
+        return false;
+    }
+    width = static_cast<unsigned int>(w);
+    height = static_cast<unsigned int>(h);
+    return true;
+}
+
+// "0,90,180": degrees, any sign
+static bool parseAngles(const char* text, std::vector<float>& angles) {
+    std::vector<float> parsed;
+    const char* p = text;
+    for (;;) {
+        char* end = nullptr;
+        float angle = std::strtof(p, &end);
+        if (end == p || (*end != ',' && *end != '\0')) {
+            return false;
+        }
+        parsed.push_back(angle);
+        if (*end == '\0') break;
+        p = end + 1;
+    }
+    angles = parsed;
+    return true;
+}
+
+// One OBJ path per line; blank lines and lines starting with '#' are skipped
+static bool readMeshList(const char* path, std::vector<std::string>& paths) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#') continue;
+        size_t last = line.find_last_not_of(" \t");
+        paths.push_back(line.substr(first, last - first + 1));
+    }
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    bool drawModeSet = false;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--no-optimize") == 0) {
+            options.optimize = false;
+        }
+        else if (std::strcmp(arg, "--no-cache") == 0) {
+            options.useCache = false;
+        }
+        else if (std::strcmp(arg, "--no-cull") == 0) {
+            options.gpuCull = false;
+        }
+        else if (std::strcmp(arg, "--meshlets") == 0) {
+            options.meshlets = true;
+        }
+        else if (std::strcmp(arg, "--outline") == 0) {
+            options.outline = true;
+        }
+        else if (std::strcmp(arg, "--depth-prepass") == 0) {
+            options.depthPrepass = true;
+        }
+        else if (std::strcmp(arg, "--sync-load") == 0) {
+            options.syncLoad = true;
+        }
+        else if (std::strcmp(arg, "--profile") == 0) {
+            options.profile = true;
+        }
+        else if (std::strcmp(arg, "--profile-csv") == 0 && value) {
+            options.profile = true;
+            options.profileCsv = value;
+            i++;
+        }
+        else if (std::strcmp(arg, "--profile-trace") == 0 && value) {
+            options.profile = true;
+            options.profileTrace = value;
+            i++;
+        }
+        else if (std::strcmp(arg, "--layout") == 0 && value) {
+            if (!parseVertexLayout(value, options.layout)) {
+                std::cerr << "Unknown vertex layout: " << value << " (expected float, half or unorm16)" << std::endl;
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(arg, "--draw") == 0 && value) {
+            if (std::strcmp(value, "single") == 0) options.drawMode = DrawMode::Single;
+            else if (std::strcmp(value, "instanced") == 0) options.drawMode = DrawMode::Instanced;
+            else if (std::strcmp(value, "indirect") == 0) options.drawMode = DrawMode::Indirect;
+            else {
+                std::cerr << "Unknown draw mode: " << value << " (expected single, instanced or indirect)" << std::endl;
+                return false;
+            }
+            drawModeSet = true;
+            i++;
+        }
+        else if (std::strcmp(arg, "--instances") == 0 && value) {
+            if (!parseCount(value, options.instanceCount)) {
+                std::cerr << "Invalid instance count: " << value << std::endl;
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(arg, "--lights") == 0 && value) {
+            if (!parseCount(value, options.lightCount)) {
+                std::cerr << "Invalid light count: " << value << std::endl;
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(arg, "--shadows") == 0) {
+            options.shadows = true;
+        }
+        else if (std::strcmp(arg, "--shadow-cascades") == 0 && value) {
+            if (!parseCount(value, options.shadowCascades) || options.shadowCascades > 4) {
+                std::cerr << "Invalid shadow cascade count (1-4): " << value << std::endl;
+                return false;
+            }
+            options.shadows = true;
+            i++;
+        }
+        else if (std::strcmp(arg, "--shadow-resolution") == 0 && value) {
+            if (!parseCount(value, options.shadowResolution) || options.shadowResolution < 64 || options.shadowResolution > 8192) {
+                std::cerr << "Invalid shadow resolution (64-8192): " << value << std::endl;
+                return false;
+            }
+            options.shadows = true;
+            i++;
+        }
+        else if (std::strcmp(arg, "--lod-error") == 0 && value) {
+            if (!parseNonNegative(value, options.lodThreshold)) {
+                std::cerr << "Invalid LOD error: " << value << std::endl;
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(arg, "--upload-budget") == 0 && value) {
+            if (!parseCount(value, options.uploadBudget)) {
+                std::cerr << "Invalid upload budget: " << value << std::endl;
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(arg, "--update-hz") == 0 && value) {
+            if (!parseCount(value, options.updateRate)) {
+                std::cerr << "Invalid update rate: " << value << std::endl;
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(arg, "--readback") == 0 && value) {
+            options.readbackOut = value;
+            i++;
+        }
+        else if (std::strcmp(arg, "--readback-frames") == 0 && value) {
+            if (!parseCount(value, options.readbackFrames) || options.readbackFrames < 2) {
+                std::cerr << "Invalid readback ring size: " << value << " (at least 2)" << std::endl;
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(arg, "--memory-report") == 0) {
+            options.memoryReport = true;
+        }
+        else if (std::strcmp(arg, "--on-demand") == 0) {
+            options.onDemand = true;
+        }
+        else if (std::strcmp(arg, "--benchmark") == 0) {
+            options.benchmark = true;
+        }
+        else if (std::strcmp(arg, "--frames") == 0 && value) {
+            if (!parseCount(value, options.benchmarkFrames)) {
+                std::cerr << "Invalid frame count: " << value << std::endl;
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(arg, "--resolution") == 0 && value) {
+            if (!parseResolution(value, options.benchmarkWidth, options.benchmarkHeight)) {
+                std::cerr << "Invalid resolution: " << value << " (expected WIDTHxHEIGHT)" << std::endl;
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(arg, "--benchmark-out") == 0 && value) {
+            options.benchmark = true;
+            options.benchmarkOut = value;
+            i++;
+        }
+        else if (std::strcmp(arg, "--shader-cache") == 0 && value) {
+            options.shaderCache = value;
+            i++;
+        }
+        else if (std::strcmp(arg, "--mesh") == 0 && value) {
+            options.meshPaths.push_back(value);
+            i++;
+        }
+        else if (std::strcmp(arg, "--mesh-list") == 0 && value) {
+            if (!readMeshList(value, options.meshPaths)) {
+                std::cerr << "Cannot read mesh list: " << value << std::endl;
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(arg, "--thumbnails") == 0 && value) {
+            options.thumbnailOut = value;
+            i++;
+        }
+        else if (std::strcmp(arg, "--thumbnail-angles") == 0 && value) {
+            if (!parseAngles(value, options.thumbnailAngles)) {
+                std::cerr << "Invalid thumbnail angles: " << value << " (expected degrees like 0,90,180)" << std::endl;
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(arg, "--thumbnail-size") == 0 && value) {
+            if (!parseCount(value, options.thumbnailSize) || options.thumbnailSize < 16 || options.thumbnailSize > 4096) {
+                std::cerr << "Invalid thumbnail size: " << value << " (16 to 4096)" << std::endl;
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(arg, "--atlas-size") == 0 && value) {
+            if (!parseCount(value, options.atlasSize) || options.atlasSize > 16384) {
+                std::cerr << "Invalid atlas size: " << value << std::endl;
+                return false;
+            }
+            i++;
+        }
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options.meshPaths.empty()) {
+        options.meshPaths.push_back("teapot.obj");
+    }
+    if (options.thumbnailAngles.empty()) {
+        options.thumbnailAngles.push_back(0.0f);
+    }
+    if (!options.thumbnailOut.empty()) {
+        unsigned int perSide = options.atlasSize / options.thumbnailSize;
+        if (perSide == 0 || perSide * perSide < options.thumbnailAngles.size()) {
+            std::cerr << "An atlas page of " << options.atlasSize << " pixels cannot hold " << options.thumbnailAngles.size()
+                      << " thumbnails of " << options.thumbnailSize << std::endl;
+            return false;
+        }
+    }
+    // Streaming would make the first frames depend on load timing
+    // and skipping frames would leave nothing to measure
+    if (options.benchmark) {
+        options.syncLoad = true;
+        options.onDemand = false;
+    }
+
+    // Several meshes and meshlet culling default to one indirect draw and a field of teapots to one
+    // instanced draw; --draw single keeps one draw per object for comparison
+    if (!drawModeSet && (options.meshPaths.size() > 1 || options.meshlets)) {
+        options.drawMode = DrawMode::Indirect;
+    }
+    else if (!drawModeSet && options.instanceCount > 1) {
+        options.drawMode = DrawMode::Instanced;
+    }
+    return true;
+}
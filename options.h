@@ -0,0 +1,54 @@
+#pragma once
+
+#include "vertex_format.h"
+
+#include <string>
+#include <vector>
+
+enum class DrawMode {
+    Single,    // one glDrawElements per object
+    Instanced, // one glDrawElementsInstanced per mesh
+    Indirect   // one glMultiDrawElementsIndirect for every mesh (GL 4.3)
+};
+
+struct Options {
+    VertexLayout layout = VertexLayout::Float;
+    bool optimize = true;
+    bool useCache = true;
+    std::string shaderCache = "shader_cache";  // directory for linked program binaries
+    DrawMode drawMode = DrawMode::Single;
+    unsigned int instanceCount = 1;
+    bool gpuCull = true;  // frustum culling in a compute pass, indirect mode only
+    bool meshlets = false;  // per-meshlet cone and frustum culling, indirect mode only
+    bool outline = false;  // screen-space silhouette and crease outlines
+    bool depthPrepass = false;  // depth-only pass first, then shade with depth writes off
+    unsigned int lightCount = 0;  // point and spot lights, shaded through a clustered light grid (GL 4.3)
+    bool shadows = false;  // cascaded shadow maps for the directional light
+    unsigned int shadowCascades = 3;  // 1 to 4, implies shadows
+    unsigned int shadowResolution = 2048;  // texels per cascade side, implies shadows
+    float lodThreshold = 1.0f;  // projected LOD error in pixels; 0 keeps full detail
+    bool syncLoad = false;  // load and upload everything before the first frame
+    unsigned int uploadBudget = 4096;  // KB streamed to the GPU per frame
+    unsigned int updateRate = 120;  // fixed camera update steps per second
+    std::string readbackOut;  // frames rendered offscreen, read back asynchronously and streamed here as PPMs
+    unsigned int readbackFrames = 3;  // pixel buffers in the readback ring, at least 2; implies nothing without readbackOut
+    bool onDemand = false;  // only draw when the camera, lights or meshes changed; wait for events otherwise
+    bool memoryReport = false;  // per-asset scratch, CPU and GPU bytes and the process's peak RSS, on exit
+    bool profile = false;  // per-stage CPU/GPU timings, overlay and console summary
+    std::string profileCsv;  // per-frame timings written here on exit, implies profile
+    std::string profileTrace;  // Chrome trace JSON written here on exit, implies profile
+    bool benchmark = false;  // hidden window, offscreen target, scripted camera, JSON results
+    unsigned int benchmarkFrames = 600;  // measured frames, after a fixed warm-up
+    unsigned int benchmarkWidth = 1920;
+    unsigned int benchmarkHeight = 1080;
+    std::string benchmarkOut;  // JSON goes to stdout when empty
+    std::string thumbnailOut;  // batch mode: atlas pages and their index are written with this prefix
+    std::vector<float> thumbnailAngles;  // degrees about Y, one thumbnail each; 0 alone when none are given
+    unsigned int thumbnailSize = 128;  // pixels per square thumbnail
+    unsigned int atlasSize = 2048;  // pixels per square atlas page
+    std::vector<std::string> meshPaths;  // teapot.obj when no --mesh is given
+};
+
+// Fills `options` from the command line; prints the problem and returns false on
+// an unknown or malformed option
+bool parseOptions(int argc, char* argv[], Options& options);
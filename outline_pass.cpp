@@ -0,0 +1,95 @@
+#include "outline_pass.h"
+#include "shaders.h"
+
+#include <glad/glad.h>
+#include <iostream>
+
+void OutlinePass::create(ProgramCache& programs, float nearPlane, float farPlane) {
+    program = programs.program(programs.request(fullscreenVertexShaderSource, outlineFragmentShader));
+    glUseProgram(program.id);
+    glUniform1i(program.location("sceneColor"), 0);
+    glUniform1i(program.location("sceneNormal"), 1);
+    glUniform1i(program.location("sceneDepth"), 2);
+    glUniform2f(program.location("depthRange"), nearPlane, farPlane);
+    glUseProgram(0);
+
+    // The full-screen triangle comes from gl_VertexID, but core profiles
+    // still want a VAO bound to draw
+    glGenVertexArrays(1, &emptyVao);
+    glGenFramebuffers(1, &fbo);
+}
+
+void OutlinePass::destroy() {
+    // The program belongs to the ProgramCache
+    glDeleteTextures(1, &colorTexture);
+    glDeleteTextures(1, &normalTexture);
+    glDeleteTextures(1, &depthTexture);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteVertexArrays(1, &emptyVao);
+    *this = OutlinePass();
+}
+
+static unsigned int createTarget(GLenum internalFormat, GLenum format, GLenum type, int width, int height) {
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+    // Only read with texelFetch, but a texture without mipmaps must not ask for them
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return texture;
+}
+
+void OutlinePass::resize(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    glDeleteTextures(1, &colorTexture);
+    glDeleteTextures(1, &normalTexture);
+    glDeleteTextures(1, &depthTexture);
+    colorTexture = createTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+    normalTexture = createTarget(GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, width, height);
+    depthTexture = createTarget(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, width, height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Outline framebuffer " << width << "x" << height << " is incomplete (0x" << std::hex << status << std::dec << ")" << std::endl;
+    }
+}
+
+void OutlinePass::begin(int targetWidth, int targetHeight, const glm::vec4& clearColor) {
+    if (targetWidth != width || targetHeight != height) {
+        resize(targetWidth, targetHeight);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
+    // Alpha 0 in the normal target marks pixels no geometry covered
+    const float noGeometry[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const float farDepth = 1.0f;
+    glClearBufferfv(GL_COLOR, 0, &clearColor[0]);
+    glClearBufferfv(GL_COLOR, 1, noGeometry);
+    glClearBufferfv(GL_DEPTH, 0, &farDepth);
+}
+
+void OutlinePass::end(unsigned int framebuffer) {
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glDisable(GL_DEPTH_TEST);
+    glUseProgram(program.id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, normalTexture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glBindVertexArray(emptyVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+    glEnable(GL_DEPTH_TEST);
+}
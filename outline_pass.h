@@ -0,0 +1,34 @@
+#pragma once
+
+#include "program_cache.h"
+
+#include <glm/glm.hpp>
+
+// Screen-space outlines. The scene is drawn into an offscreen colour, normal
+// and depth target. One full-screen pass then darkens pixels where linear depth
+// kinks (silhouettes and overlaps) or the normal turns sharply (creases), and
+// writes the result to the real target. The cost is one full-screen pass
+// however much geometry there is, instead of drawing every mesh again as lines.
+class OutlinePass {
+public:
+    void create(ProgramCache& programs, float nearPlane, float farPlane);
+    void destroy();
+
+    // Binds the offscreen target, reallocated when the size changes, and clears
+    // colour to `clearColor`, normals to "no geometry" and depth to far
+    void begin(int width, int height, const glm::vec4& clearColor);
+    // Outlines the offscreen image into `framebuffer` (0 is the window)
+    void end(unsigned int framebuffer);
+
+private:
+    void resize(int width, int height);
+
+    ShaderProgram program;
+    unsigned int fbo = 0;
+    unsigned int colorTexture = 0;
+    unsigned int normalTexture = 0;
+    unsigned int depthTexture = 0;
+    unsigned int emptyVao = 0;
+    int width = 0;
+    int height = 0;
+};
@@ -0,0 +1,448 @@
+#include "perf_suite.h"
+#include "benchmark.h"
+#include "mesh_optimize.h"
+#include "mesh_simplify.h"
+#include "obj_loader.h"
+#include "program_cache.h"
+#include "shader_program.h"
+#include "shaders.h"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Vertices per side of the generated grid: 262144 vertices, 522242 triangles
+// and about 20 MB of OBJ text
+static const int kSyntheticGridSide = 512;
+
+// Draw modes timed through --benchmark child processes, all on the same field
+static const char* kFrameModes[] = { "single", "instanced", "indirect" };
+static const char* kFrameArguments = " --benchmark --sync-load --instances 100 --frames 300 --resolution 1280x720";
+
+// Median wall time in ms of `run` over `iterations`; `setup` runs untimed before each
+static double medianMs(const std::function<void()>& setup, const std::function<void()>& run, int iterations) {
+    std::vector<double> times;
+    for (int i = 0; i < iterations; i++) {
+        if (setup) setup();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto stop = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// A gently rolling height field with a normal per vertex and v//vn corners,
+// written the way exporters do: all positions, all normals, then the faces
+static bool writeSyntheticGrid(const std::string& path) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    const int side = kSyntheticGridSide;
+    char line[128];
+    // y = 0.5 sin(0.05 x) cos(0.07 z) over a grid spaced 0.01 apart
+    for (int z = 0; z < side; z++) {
+        for (int x = 0; x < side; x++) {
+            float y = 0.5f * std::sin(x * 0.05f) * std::cos(z * 0.07f);
+            int length = std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", x * 0.01f, y, z * 0.01f);
+            file.write(line, length);
+        }
+    }
+    for (int z = 0; z < side; z++) {
+        for (int x = 0; x < side; x++) {
+            // Slopes of the height field per unit of world distance
+            float dx = 2.5f * std::cos(x * 0.05f) * std::cos(z * 0.07f);
+            float dz = -3.5f * std::sin(x * 0.05f) * std::sin(z * 0.07f);
+            float length = std::sqrt(dx * dx + 1.0f + dz * dz);
+            int written = std::snprintf(line, sizeof(line), "vn %.6f %.6f %.6f\n", -dx / length, 1.0f / length, -dz / length);
+            file.write(line, written);
+        }
+    }
+    for (int z = 0; z + 1 < side; z++) {
+        for (int x = 0; x + 1 < side; x++) {
+            int a = z * side + x + 1, b = a + 1, c = a + side, d = c + 1;
+            int length = std::snprintf(line, sizeof(line), "f %d//%d %d//%d %d//%d\nf %d//%d %d//%d %d//%d\n",
+                                       a, a, c, c, b, b, b, b, c, c, d, d);
+            file.write(line, length);
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+// loadOBJ on one thread and on all of them
+static std::string loadSection(const std::string& path, int iterations) {
+    double megabytes = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+    unsigned int threads = std::max(std::thread::hardware_concurrency(), 1u);
+    Mesh mesh;
+    auto reset = [&mesh] { mesh = Mesh(); };
+    double serialMs = medianMs(reset, [&] { mesh = loadOBJ(path.c_str(), 1); }, iterations);
+    double threadedMs = medianMs(reset, [&] { mesh = loadOBJ(path.c_str(), threads); }, iterations);
+    double triangles = static_cast<double>(mesh.indices.size() / 3);
+
+    std::ostringstream out;
+    out << "{ \"triangles\": " << mesh.indices.size() / 3 << ", \"megabytes\": " << megabytes
+        << ", \"serial_ms\": " << serialMs << ", \"threaded_ms\": " << threadedMs
+        << ", \"serial_mb_per_second\": " << megabytes * 1000.0 / serialMs
+        << ", \"threaded_mb_per_second\": " << megabytes * 1000.0 / threadedMs
+        << ", \"serial_triangles_per_second\": " << triangles * 1000.0 / serialMs
+        << ", \"threaded_triangles_per_second\": " << triangles * 1000.0 / threadedMs << " }";
+    std::cerr << path << ": " << serialMs << " ms on 1 thread, " << threadedMs << " ms on " << threads << std::endl;
+    return out.str();
+}
+
+// Each optimizeMesh pass on the input it gets at load time, then the LOD chain
+static std::string optimizeSection(const std::string& path, int iterations) {
+    const Mesh source = loadOBJ(path.c_str());
+    Mesh cacheOrdered = source;
+    optimizeVertexCache(cacheOrdered.indices, cacheOrdered.vertices.size());
+    Mesh optimized = source;
+    optimizeMesh(optimized);
+
+    Mesh mesh;
+    double vertexCacheMs = medianMs([&] { mesh = source; }, [&] { optimizeVertexCache(mesh.indices, mesh.vertices.size()); }, iterations);
+    double overdrawMs = medianMs([&] { mesh = cacheOrdered; }, [&] { optimizeOverdraw(mesh.indices, mesh.vertices); }, iterations);
+    double vertexFetchMs = medianMs([&] { mesh = cacheOrdered; }, [&] { optimizeVertexFetch(mesh); }, iterations);
+    double lodChainMs = medianMs([&] { mesh = optimized; }, [&] { buildLodChain(mesh); }, iterations);
+
+    std::ostringstream out;
+    out << "{ \"vertex_cache_ms\": " << vertexCacheMs << ", \"overdraw_ms\": " << overdrawMs
+        << ", \"vertex_fetch_ms\": " << vertexFetchMs << ", \"lod_chain_ms\": " << lodChainMs << " }";
+    std::cerr << path << ": optimized in " << vertexCacheMs + overdrawMs + vertexFetchMs << " ms, LODs in " << lodChainMs << " ms" << std::endl;
+    return out.str();
+}
+
+// The viewer's four base programs: cold is the first link of each in this
+// process, warm the median of linking them again, and the cache time a
+// ProgramCache start once their binaries are stored. Needs a hidden window
+// for the context; returns an empty string without one.
+static std::string shaderSection(int iterations) {
+    if (!glfwInit()) {
+        std::cerr << "Failed to initialize GLFW, skipping shader timings" << std::endl;
+        return std::string();
+    }
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = nullptr;
+    const int versions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 3 }, { 3, 3 } };
+    for (const int* version : versions) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        window = glfwCreateWindow(64, 64, "perf suite", nullptr, nullptr);
+        if (window) break;
+    }
+    if (!window) {
+        std::cerr << "Failed to create a GL context, skipping shader timings" << std::endl;
+        glfwTerminate();
+        return std::string();
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD, skipping shader timings" << std::endl;
+        glfwTerminate();
+        return std::string();
+    }
+
+    const std::string shadingSource = shadingFragmentShader(false, false);
+    const char* sources[][2] = {
+        { vertexShaderSource, shadingSource.c_str() },
+        { instancedVertexShaderSource, shadingSource.c_str() },
+        { depthVertexShaderSource, depthFragmentShaderSource },
+        { depthInstancedVertexShaderSource, depthFragmentShaderSource },
+    };
+    auto linkAll = [&sources] {
+        for (const auto& program : sources) {
+            glDeleteProgram(createShaderProgram(program[0], program[1]));
+        }
+    };
+    double coldMs = medianMs(nullptr, linkAll, 1);
+    double warmMs = medianMs(nullptr, linkAll, iterations);
+
+    const std::string cacheDirectory = (std::filesystem::temp_directory_path() / "perf_suite_shader_cache").string();
+    std::error_code error;
+    std::filesystem::remove_all(cacheDirectory, error);
+    std::string report;
+    auto startCache = [&] {
+        ProgramCache programs;
+        programs.create(cacheDirectory);
+        std::vector<int> handles;
+        for (const auto& program : sources) {
+            handles.push_back(programs.request(program[0], program[1]));
+        }
+        for (int handle : handles) {
+            programs.program(handle);
+        }
+        report = programs.report();
+        programs.destroy();
+    };
+    startCache();
+    double cacheMs = medianMs(nullptr, startCache, iterations);
+    std::filesystem::remove_all(cacheDirectory, error);
+
+    std::ostringstream out;
+    out << "{ \"renderer\": " << jsonString(reinterpret_cast<const char*>(glGetString(GL_RENDERER)))
+        << ", \"programs\": " << sizeof(sources) / sizeof(sources[0]) << ", \"cold_ms\": " << coldMs
+        << ", \"warm_ms\": " << warmMs << ", \"binary_cache_ms\": " << cacheMs
+        << ", \"binary_cache\": " << jsonString(report.c_str()) << " }";
+    std::cerr << "Shaders: " << coldMs << " ms cold, " << warmMs << " ms warm, " << cacheMs << " ms from the cache (" << report << ")" << std::endl;
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return out.str();
+}
+
+// Runs `executable --benchmark` for one draw mode and returns its JSON, or an
+// empty string when it fails. Its console output is discarded, so the suite's
+// own JSON can go to stdout.
+static std::string frameSection(const char* executable, const char* mode) {
+    const std::string resultPath = (std::filesystem::temp_directory_path() / (std::string("perf_suite_frame_") + mode + ".json")).string();
+    std::error_code error;
+    std::filesystem::remove(resultPath, error);
+#ifdef _WIN32
+    const char* discard = " > NUL";
+#else
+    const char* discard = " > /dev/null";
+#endif
+    std::string command = std::string("\"") + executable + "\"" + kFrameArguments + " --draw " + mode +
+        " --benchmark-out \"" + resultPath + "\"" + discard;
+#ifdef _WIN32
+    // cmd.exe strips the outer pair when the command starts with a quote
+    command = "\"" + command + "\"";
+#endif
+    int status = std::system(command.c_str());
+    std::ifstream file(resultPath);
+    std::stringstream json;
+    json << file.rdbuf();
+    std::filesystem::remove(resultPath, error);
+    std::string text = json.str();
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.pop_back();
+    if (status != 0 || text.empty()) {
+        std::cerr << "Frame benchmark for --draw " << mode << " failed" << std::endl;
+        return std::string();
+    }
+    std::cerr << "Frame benchmark for --draw " << mode << " done" << std::endl;
+    return text;
+}
+
+int runPerfSuite(const char* executable, const std::string& outPath, int iterations) {
+    iterations = std::max(iterations, 1);
+    const std::string gridPath = (std::filesystem::temp_directory_path() / "perf_suite_grid.obj").string();
+    if (!std::filesystem::exists("teapot.obj") || !writeSyntheticGrid(gridPath)) {
+        std::cerr << "The suite needs teapot.obj in the working directory and a writable temp directory" << std::endl;
+        return -1;
+    }
+
+    // Sections that could not run are left out, which --bench-compare reports
+    // as missing
+    std::vector<std::pair<std::string, std::string>> sections;
+    sections.emplace_back("load_teapot", loadSection("teapot.obj", iterations));
+    sections.emplace_back("load_synthetic", loadSection(gridPath, iterations));
+    sections.emplace_back("optimize_teapot", optimizeSection("teapot.obj", iterations));
+    sections.emplace_back("optimize_synthetic", optimizeSection(gridPath, iterations));
+    std::error_code error;
+    std::filesystem::remove(gridPath, error);
+    sections.emplace_back("shaders", shaderSection(iterations));
+    for (const char* mode : kFrameModes) {
+        sections.emplace_back(std::string("frame_") + mode, frameSection(executable, mode));
+    }
+
+    bool complete = true;
+    std::ostringstream out;
+    out << "{\n  \"iterations\": " << iterations << ",\n  \"threads\": " << std::max(std::thread::hardware_concurrency(), 1u);
+    for (const auto& section : sections) {
+        if (section.second.empty()) {
+            complete = false;
+            continue;
+        }
+        out << ",\n  \"" << section.first << "\": " << section.second;
+    }
+    out << "\n}\n";
+
+    if (outPath.empty()) {
+        std::cout << out.str() << std::flush;
+    }
+    else {
+        std::ofstream file(outPath);
+        if (!file || !(file << out.str())) {
+            std::cerr << "Failed to write suite results: " << outPath << std::endl;
+            return 1;
+        }
+    }
+    return complete ? 0 : 1;
+}
+
+// A results file flattened to dotted keys ("frame_single.frame_ms.p50",
+// "frame_single.resolution[0]"): numbers apart, strings and literals as text
+struct FlatJson {
+    std::map<std::string, double> numbers;
+    std::map<std::string, std::string> text;
+};
+
+struct JsonCursor {
+    const char* p;
+    const char* end;
+
+    void skipSpace() {
+        while (p < end && std::isspace(static_cast<unsigned char>(*p))) p++;
+    }
+    bool consume(char c) {
+        skipSpace();
+        if (p < end && *p == c) {
+            p++;
+            return true;
+        }
+        return false;
+    }
+};
+
+// Escapes are kept as written except for quotes and backslashes; the keys
+// and values compared here are plain ASCII
+static bool parseJsonString(JsonCursor& cursor, std::string& out) {
+    if (!cursor.consume('"')) return false;
+    out.clear();
+    while (cursor.p < cursor.end && *cursor.p != '"') {
+        if (*cursor.p == '\\' && cursor.p + 1 < cursor.end) {
+            cursor.p++;
+            if (*cursor.p != '"' && *cursor.p != '\\') out += '\\';
+        }
+        out += *cursor.p++;
+    }
+    return cursor.consume('"');
+}
+
+static bool parseJsonValue(JsonCursor& cursor, const std::string& key, FlatJson& flat) {
+    cursor.skipSpace();
+    if (cursor.p >= cursor.end) return false;
+    if (cursor.consume('{')) {
+        if (cursor.consume('}')) return true;
+        do {
+            std::string name;
+            if (!parseJsonString(cursor, name) || !cursor.consume(':') ||
+                !parseJsonValue(cursor, key.empty() ? name : key + "." + name, flat)) {
+                return false;
+            }
+        } while (cursor.consume(','));
+        return cursor.consume('}');
+    }
+    if (cursor.consume('[')) {
+        if (cursor.consume(']')) return true;
+        size_t index = 0;
+        do {
+            if (!parseJsonValue(cursor, key + "[" + std::to_string(index++) + "]", flat)) return false;
+        } while (cursor.consume(','));
+        return cursor.consume(']');
+    }
+    if (*cursor.p == '"') {
+        return parseJsonString(cursor, flat.text[key]);
+    }
+    for (const char* literal : { "true", "false", "null" }) {
+        size_t length = std::strlen(literal);
+        if (static_cast<size_t>(cursor.end - cursor.p) >= length && std::strncmp(cursor.p, literal, length) == 0) {
+            flat.text[key] = literal;
+            cursor.p += length;
+            return true;
+        }
+    }
+    char* numberEnd = nullptr;
+    double number = std::strtod(cursor.p, &numberEnd);
+    if (numberEnd == cursor.p) return false;
+    flat.numbers[key] = number;
+    cursor.p = numberEnd;
+    return true;
+}
+
+static bool readFlatJson(const std::string& path, FlatJson& flat) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+    JsonCursor cursor{ text.data(), text.data() + text.size() };
+    if (!parseJsonValue(cursor, std::string(), flat)) {
+        std::cerr << "Cannot parse " << path << " as JSON" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+enum class MetricKind { Context, Time, Rate };
+
+static MetricKind metricKind(const std::string& key) {
+    std::string segment, last;
+    std::istringstream segments(key);
+    bool time = false;
+    while (std::getline(segments, segment, '.')) {
+        last = segment.substr(0, segment.find('['));
+        time = time || (last.size() > 3 && last.compare(last.size() - 3, 3, "_ms") == 0);
+    }
+    if (time) return MetricKind::Time;
+    if (last.find("per_second") != std::string::npos || last == "fps") return MetricKind::Rate;
+    return MetricKind::Context;
+}
+
+int runPerfCompare(const std::string& baselinePath, const std::string& currentPath, double thresholdPercent) {
+    FlatJson baseline, current;
+    if (!readFlatJson(baselinePath, baseline) || !readFlatJson(currentPath, current)) {
+        return -1;
+    }
+
+    // Different hardware or drivers make the comparison meaningless; say so
+    for (const auto& entry : baseline.text) {
+        auto other = current.text.find(entry.first);
+        if (other != current.text.end() && other->second != entry.second && entry.first.find("renderer") != std::string::npos) {
+            std::cout << "note: " << entry.first << " differs: " << entry.second << " / " << other->second << "\n";
+        }
+    }
+
+    int regressions = 0, missing = 0;
+    std::cout << std::left << std::setw(56) << "metric" << std::right << std::setw(14) << "baseline" << std::setw(14) << "current"
+              << std::setw(10) << "worse" << "\n";
+    for (const auto& entry : baseline.numbers) {
+        MetricKind kind = metricKind(entry.first);
+        if (kind == MetricKind::Context) continue;
+        auto other = current.numbers.find(entry.first);
+        if (other == current.numbers.end()) {
+            std::cout << std::left << std::setw(56) << entry.first << std::right << std::setw(14) << entry.second
+                      << std::setw(14) << "-" << "  MISSING\n";
+            missing++;
+            continue;
+        }
+        // Positive when the current run is slower, whichever way the metric points
+        double worse = 0.0;
+        if (entry.second > 0.0) {
+            worse = kind == MetricKind::Time ? (other->second - entry.second) / entry.second : (entry.second - other->second) / entry.second;
+        }
+        bool regressed = worse * 100.0 > thresholdPercent;
+        regressions += regressed ? 1 : 0;
+        std::cout << std::left << std::setw(56) << entry.first << std::right << std::setw(14) << entry.second << std::setw(14) << other->second
+                  << std::setw(9) << std::showpos << std::fixed << std::setprecision(1) << worse * 100.0 << "%" << std::noshowpos
+                  << std::defaultfloat << std::setprecision(6) << (regressed ? "  REGRESSION" : "") << "\n";
+    }
+    for (const auto& entry : current.numbers) {
+        if (metricKind(entry.first) != MetricKind::Context && !baseline.numbers.count(entry.first)) {
+            std::cout << std::left << std::setw(56) << entry.first << std::right << std::setw(14) << "-" << std::setw(14) << entry.second
+                      << "  NEW\n";
+        }
+    }
+    std::cout << regressions << " regressed by more than " << thresholdPercent << "%, " << missing << " missing" << std::endl;
+    return regressions || missing ? 1 : 0;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+// Times the loader and renderer hot paths and writes one JSON object of
+// results to `outPath` (stdout when empty): loadOBJ on teapot.obj and on a
+// generated grid mesh, serial and threaded, in MB/s and triangles/s; each
+// optimizeMesh pass and buildLodChain; createShaderProgram cold (first link
+// in the process) and warm, and a ProgramCache start from stored binaries;
+// and the headless --benchmark of each draw mode, run as child processes of
+// `executable`. CPU timings are medians over `iterations`. Returns the
+// process exit code.
+int runPerfSuite(const char* executable, const std::string& outPath, int iterations);
+
+// Compares two JSON result files from --bench-suite or --benchmark-out. Every
+// number whose key ends in "_ms" or lies inside such an object is a time,
+// lower is better; keys with "per_second" and "fps" are rates, higher is
+// better; everything else is context. Prints every timed metric and returns 1
+// when any got worse than the baseline by more than `thresholdPercent`, or is
+// missing from `currentPath`, and 0 otherwise.
+int runPerfCompare(const std::string& baselinePath, const std::string& currentPath, double thresholdPercent);
@@ -0,0 +1,342 @@
+#include "profiler.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// About four seconds at 60 Hz
+static const size_t kStatsWindow = 240;
+
+void FrameProfiler::Window::push(float value) {
+    if (values.size() < kStatsWindow) {
+        values.push_back(value);
+    }
+    else {
+        values[next] = value;
+    }
+    next = (next + 1) % kStatsWindow;
+}
+
+StageStats FrameProfiler::Window::stats() const {
+    StageStats stats;
+    stats.samples = values.size();
+    if (values.empty()) {
+        return stats;
+    }
+    std::vector<float> sorted = values;
+    size_t p99 = (sorted.size() * 99 + 99) / 100 - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + p99, sorted.end());
+    stats.p99 = sorted[p99];
+    stats.min = *std::min_element(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (float value : sorted) sum += value;
+    stats.avg = static_cast<float>(sum / sorted.size());
+    return stats;
+}
+
+int FrameProfiler::addStage(const char* name) {
+    stageNames.push_back(name);
+    return static_cast<int>(stageNames.size() - 1);
+}
+
+int FrameProfiler::addCounter(const char* name) {
+    counterNames.push_back(name);
+    return static_cast<int>(counterNames.size() - 1);
+}
+
+double FrameProfiler::nowUs() const {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double, std::micro>(now).count() - epochUs;
+}
+
+void FrameProfiler::create(bool recordHistory) {
+    size_t stages = stageNames.size();
+    keepHistory = recordHistory;
+    epochUs = 0.0;
+    epochUs = nowUs();
+    queries.resize(kProfileLatency * stages);
+    if (!queries.empty()) {
+        glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+    }
+    counterQueries.resize(kProfileLatency * counterNames.size());
+    if (!counterQueries.empty()) {
+        glGenQueries(static_cast<GLsizei>(counterQueries.size()), counterQueries.data());
+    }
+    pending.assign(kProfileLatency, FrameRecord());
+    pendingValid.assign(kProfileLatency, false);
+    cpuWindows.assign(stages, Window());
+    gpuWindows.assign(stages, Window());
+    counterWindows.assign(counterNames.size(), Window());
+    frameWindow = Window();
+    history.clear();
+    slot = 0;
+    active = true;
+}
+
+void FrameProfiler::destroy() {
+    if (!queries.empty()) {
+        glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+    }
+    if (!counterQueries.empty()) {
+        glDeleteQueries(static_cast<GLsizei>(counterQueries.size()), counterQueries.data());
+    }
+    *this = FrameProfiler();
+}
+
+void FrameProfiler::beginFrame() {
+    if (!active) return;
+    if (pendingValid[slot]) {
+        collect(slot, false);
+    }
+    FrameRecord& record = pending[slot];
+    record.startUs = nowUs();
+    record.frameMs = 0.0f;
+    record.cpuStartUs.assign(stageNames.size(), 0.0);
+    record.cpuMs.assign(stageNames.size(), -1.0f);
+    record.gpuMs.assign(stageNames.size(), -1.0f);
+    record.counterStartUs.assign(counterNames.size(), 0.0);
+    record.samples.assign(counterNames.size(), -1.0);
+    record.counted.assign(counterNames.size(), false);
+}
+
+void FrameProfiler::beginStage(int stage) {
+    if (!active) return;
+    pending[slot].cpuStartUs[stage] = nowUs();
+    glBeginQuery(GL_TIME_ELAPSED, queries[slot * stageNames.size() + stage]);
+}
+
+void FrameProfiler::endStage(int stage) {
+    if (!active) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    FrameRecord& record = pending[slot];
+    record.cpuMs[stage] = static_cast<float>((nowUs() - record.cpuStartUs[stage]) / 1000.0);
+}
+
+void FrameProfiler::beginCounter(int counter) {
+    if (!active) return;
+    pending[slot].counterStartUs[counter] = nowUs();
+    pending[slot].counted[counter] = true;
+    glBeginQuery(GL_SAMPLES_PASSED, counterQueries[slot * counterNames.size() + counter]);
+}
+
+void FrameProfiler::endCounter(int counter) {
+    if (!active) return;
+    glEndQuery(GL_SAMPLES_PASSED);
+}
+
+void FrameProfiler::endFrame() {
+    if (!active) return;
+    FrameRecord& record = pending[slot];
+    record.frameMs = static_cast<float>((nowUs() - record.startUs) / 1000.0);
+    pendingValid[slot] = true;
+    slot = (slot + 1) % kProfileLatency;
+}
+
+void FrameProfiler::collect(unsigned int set, bool wait) {
+    FrameRecord& record = pending[set];
+    for (size_t stage = 0; stage < stageNames.size(); stage++) {
+        if (record.cpuMs[stage] < 0.0f) {
+            continue;
+        }
+        unsigned int query = queries[set * stageNames.size() + stage];
+        int available = GL_TRUE;
+        if (!wait) {
+            glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        }
+        if (available) {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+            record.gpuMs[stage] = static_cast<float>(elapsed / 1.0e6);
+            gpuWindows[stage].push(record.gpuMs[stage]);
+        }
+        cpuWindows[stage].push(record.cpuMs[stage]);
+    }
+    for (size_t counter = 0; counter < counterNames.size(); counter++) {
+        if (!record.counted[counter]) {
+            continue;
+        }
+        unsigned int query = counterQueries[set * counterNames.size() + counter];
+        int available = GL_TRUE;
+        if (!wait) {
+            glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        }
+        if (available) {
+            GLuint64 samples = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &samples);
+            record.samples[counter] = static_cast<double>(samples);
+            counterWindows[counter].push(static_cast<float>(samples));
+        }
+    }
+    frameWindow.push(record.frameMs);
+    if (keepHistory) {
+        history.push_back(record);
+    }
+    pendingValid[set] = false;
+}
+
+void FrameProfiler::finish() {
+    if (!active) return;
+    // `slot` is the oldest set still in flight
+    for (unsigned int i = 0; i < kProfileLatency; i++) {
+        unsigned int set = (slot + i) % kProfileLatency;
+        if (pendingValid[set]) collect(set, true);
+    }
+}
+
+StageStats FrameProfiler::cpuStats(int stage) const {
+    return cpuWindows[stage].stats();
+}
+
+StageStats FrameProfiler::gpuStats(int stage) const {
+    return gpuWindows[stage].stats();
+}
+
+StageStats FrameProfiler::frameStats() const {
+    return frameWindow.stats();
+}
+
+StageStats FrameProfiler::counterStats(int counter) const {
+    return counterWindows[counter].stats();
+}
+
+static void printStats(std::ostream& out, const StageStats& stats) {
+    out << std::setw(7) << stats.min << std::setw(7) << stats.avg << std::setw(7) << stats.p99;
+}
+
+std::string FrameProfiler::summary() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    out << "stage ms      cpu min    avg    p99    gpu min    avg    p99\n";
+    out << std::left << std::setw(10) << "frame" << std::right << "   ";
+    printStats(out, frameStats());
+    out << "\n";
+    for (size_t stage = 0; stage < stageNames.size(); stage++) {
+        out << std::left << std::setw(10) << stageNames[stage] << std::right << "   ";
+        printStats(out, cpuStats(static_cast<int>(stage)));
+        out << "       ";
+        printStats(out, gpuStats(static_cast<int>(stage)));
+        out << "\n";
+    }
+    // Counters that never ran this window are left out
+    bool header = false;
+    out << std::setprecision(0);
+    for (size_t counter = 0; counter < counterNames.size(); counter++) {
+        StageStats stats = counterStats(static_cast<int>(counter));
+        if (stats.samples == 0) continue;
+        if (!header) {
+            out << "samples         min        avg        p99\n";
+            header = true;
+        }
+        out << std::left << std::setw(10) << counterNames[counter] << std::right
+            << std::setw(11) << stats.min << std::setw(11) << stats.avg << std::setw(11) << stats.p99 << "\n";
+    }
+    return out.str();
+}
+
+void FrameProfiler::drawOverlay(int width, int height) const {
+    if (!active) return;
+    static const float palette[][3] = {
+        { 0.90f, 0.30f, 0.25f }, { 0.95f, 0.70f, 0.20f }, { 0.35f, 0.75f, 0.30f }, { 0.25f, 0.55f, 0.95f },
+        { 0.65f, 0.40f, 0.90f }, { 0.20f, 0.80f, 0.80f }, { 0.90f, 0.45f, 0.70f }, { 0.70f, 0.70f, 0.70f },
+    };
+    const int margin = 10, barHeight = 8, gap = 3;
+    const float fullScaleMs = 1000.0f / 30.0f;
+    float pixelsPerMs = (width - 2 * margin) / fullScaleMs;
+
+    float clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    glEnable(GL_SCISSOR_TEST);
+    auto fill = [](int x, int y, int w, int h, float r, float g, float b) {
+        glScissor(x, y, std::max(w, 1), h);
+        glClearColor(r, g, b, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    };
+
+    int top = height - margin - barHeight;
+    fill(margin - 2, top - barHeight - gap - 2, width - 2 * margin + 4, 2 * barHeight + gap + 4, 0.05f, 0.05f, 0.05f);
+    for (int row = 0; row < 2; row++) {
+        int y = top - row * (barHeight + gap);
+        float x = static_cast<float>(margin);
+        for (size_t stage = 0; stage < stageNames.size(); stage++) {
+            StageStats stats = row == 0 ? cpuStats(static_cast<int>(stage)) : gpuStats(static_cast<int>(stage));
+            float w = std::min(stats.avg * pixelsPerMs, width - margin - x);
+            if (stats.samples == 0 || w <= 0.0f) continue;
+            const float* color = palette[stage % 8];
+            fill(static_cast<int>(x), y, static_cast<int>(w + 0.5f), barHeight, color[0], color[1], color[2]);
+            x += w;
+        }
+    }
+    int tick = margin + static_cast<int>(pixelsPerMs * 1000.0f / 60.0f);
+    fill(tick, top - barHeight - gap - 2, 1, 2 * barHeight + gap + 4, 1.0f, 1.0f, 1.0f);
+
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+bool FrameProfiler::writeCsv(const char* path) const {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Failed to write profile CSV: " << path << std::endl;
+        return false;
+    }
+    file << "frame,frame_ms";
+    for (const std::string& name : stageNames) file << "," << name << "_cpu_ms," << name << "_gpu_ms";
+    for (const std::string& name : counterNames) file << "," << name << "_samples";
+    file << "\n";
+    for (size_t frame = 0; frame < history.size(); frame++) {
+        const FrameRecord& record = history[frame];
+        file << frame << "," << record.frameMs;
+        for (size_t stage = 0; stage < stageNames.size(); stage++) {
+            file << ",";
+            if (record.cpuMs[stage] >= 0.0f) file << record.cpuMs[stage];
+            file << ",";
+            if (record.gpuMs[stage] >= 0.0f) file << record.gpuMs[stage];
+        }
+        for (size_t counter = 0; counter < counterNames.size(); counter++) {
+            file << ",";
+            if (record.samples[counter] >= 0.0) file << static_cast<uint64_t>(record.samples[counter]);
+        }
+        file << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+bool FrameProfiler::writeChromeTrace(const char* path) const {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Failed to write profile trace: " << path << std::endl;
+        return false;
+    }
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n"
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+    auto event = [&file](const std::string& name, const char* category, int thread, double start, double duration) {
+        file << ",\n{\"name\":\"" << name << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread
+             << ",\"ts\":" << start << ",\"dur\":" << duration << "}";
+    };
+    double gpuCursor = 0.0;
+    for (const FrameRecord& record : history) {
+        event("frame", "cpu", 1, record.startUs, record.frameMs * 1000.0);
+        for (size_t stage = 0; stage < stageNames.size(); stage++) {
+            if (record.cpuMs[stage] < 0.0f) continue;
+            event(stageNames[stage], "cpu", 1, record.cpuStartUs[stage], record.cpuMs[stage] * 1000.0);
+            if (record.gpuMs[stage] < 0.0f) continue;
+            gpuCursor = std::max(gpuCursor, record.cpuStartUs[stage]);
+            event(stageNames[stage], "gpu", 2, gpuCursor, record.gpuMs[stage] * 1000.0);
+            gpuCursor += record.gpuMs[stage] * 1000.0;
+        }
+        for (size_t counter = 0; counter < counterNames.size(); counter++) {
+            if (record.samples[counter] < 0.0) continue;
+            file << ",\n{\"name\":\"" << counterNames[counter] << "\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":"
+                 << record.counterStartUs[counter] << ",\"args\":{\"samples\":" << static_cast<uint64_t>(record.samples[counter]) << "}}";
+        }
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
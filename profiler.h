@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Frames between issuing a stage's query and reading it back
+const unsigned int kProfileLatency = 3;
+
+// min/avg/p99 over the profiler's rolling window, in milliseconds
+struct StageStats {
+    float min = 0.0f;
+    float avg = 0.0f;
+    float p99 = 0.0f;
+    size_t samples = 0;
+};
+
+// Brackets named stages of the frame with a CPU clock and a GL_TIME_ELAPSED
+// query each. Queries rotate through kProfileLatency sets and are read a few
+// frames later, so the CPU never waits on the GPU; a result that is still not
+// ready is dropped rather than waited for. Stages must not nest, because only
+// one elapsed-time query can be active at a time. Counters bracket draws with
+// a GL_SAMPLES_PASSED query the same way, to measure overdraw; they may
+// overlap stages but not each other. Every call is a no-op until create().
+class FrameProfiler {
+public:
+    // Stages and counters are added before create(); the returned id is passed
+    // to begin/endStage or begin/endCounter
+    int addStage(const char* name);
+    int addCounter(const char* name);
+    // `recordHistory` keeps every frame for writeCsv() and writeChromeTrace()
+    void create(bool recordHistory);
+    void destroy();
+    bool enabled() const { return active; }
+
+    void beginFrame();
+    void beginStage(int stage);
+    void endStage(int stage);
+    void beginCounter(int counter);
+    void endCounter(int counter);
+    void endFrame();
+
+    StageStats cpuStats(int stage) const;
+    StageStats gpuStats(int stage) const;
+    StageStats frameStats() const;
+    // In samples rather than milliseconds
+    StageStats counterStats(int counter) const;
+    // One line per stage with the CPU and GPU min/avg/p99, then one per counter
+    std::string summary() const;
+
+    // Two stacked bars in the corner, CPU above GPU, one colour per stage; the
+    // full width is two 60 Hz frames and the tick marks 16.7 ms
+    void drawOverlay(int width, int height) const;
+
+    // Blocks for the queries still in flight; call before writing the history
+    void finish();
+    // One row per frame; a stage or counter that did not run that frame is left empty
+    bool writeCsv(const char* path) const;
+    // Chrome trace event JSON (chrome://tracing, Perfetto). CPU stages are on
+    // thread 1; GPU stages are on thread 2, each placed at the later of its
+    // CPU submission and the end of the previous GPU stage, since elapsed-time
+    // queries carry no timestamps. Counters are counter events on the CPU thread.
+    bool writeChromeTrace(const char* path) const;
+
+private:
+    struct FrameRecord {
+        double startUs = 0.0;
+        float frameMs = 0.0f;
+        std::vector<double> cpuStartUs;
+        std::vector<float> cpuMs;  // -1 when the stage did not run
+        std::vector<float> gpuMs;  // -1 when it did not run or was dropped
+        std::vector<double> counterStartUs;
+        std::vector<double> samples;  // -1 when the counter did not run or was dropped
+        std::vector<bool> counted;    // began this frame
+    };
+
+    // Rolling window of one value per frame
+    struct Window {
+        std::vector<float> values;
+        size_t next = 0;
+        void push(float value);
+        StageStats stats() const;
+    };
+
+    double nowUs() const;
+    void collect(unsigned int slot, bool wait);
+
+    bool active = false;
+    bool keepHistory = false;
+    std::vector<std::string> stageNames;
+    std::vector<std::string> counterNames;
+    std::vector<unsigned int> queries;   // kProfileLatency x stages
+    std::vector<unsigned int> counterQueries;  // kProfileLatency x counters
+    std::vector<FrameRecord> pending;    // one per query set
+    std::vector<bool> pendingValid;
+    unsigned int slot = 0;
+    double epochUs = 0.0;
+    std::vector<Window> cpuWindows, gpuWindows, counterWindows;
+    Window frameWindow;
+    std::vector<FrameRecord> history;
+};
@@ -0,0 +1,222 @@
+#include "program_cache.h"
+
+#include <glad/glad.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+static const uint32_t kBinaryMagic = 0x42505243;  // "CRPB"
+static const uint32_t kBinaryVersion = 1;
+
+struct BinaryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t size;
+};
+
+// 64-bit FNV-1a; the inputs are a few kilobytes of GLSL
+static uint64_t hashString(const std::string& text, uint64_t hash = 1469598103934665603ull) {
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static std::string glString(GLenum name) {
+    const char* value = reinterpret_cast<const char*>(glGetString(name));
+    return value ? value : "";
+}
+
+void ProgramCache::create(const std::string& cacheDirectory) {
+    directory = cacheDirectory;
+    driver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+
+    // Program binaries are core in 4.1; a driver may still offer no formats
+    int formats = 0;
+    if (GLAD_GL_VERSION_4_1 && !directory.empty()) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+    binaries = formats > 0;
+    if (binaries) {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error) {
+            std::cerr << "Failed to create shader cache " << directory << ": " << error.message() << std::endl;
+            binaries = false;
+        }
+    }
+
+    // Let the driver use as many compiler threads as it likes
+    if (GLAD_GL_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+        parallel = true;
+    }
+    else if (GLAD_GL_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+        parallel = true;
+    }
+}
+
+void ProgramCache::destroy() {
+    for (Entry& entry : entries) {
+        for (const Stage& stage : entry.stages) {
+            if (stage.shader) glDeleteShader(stage.shader);
+        }
+        destroyShaderProgram(entry.program);
+    }
+    *this = ProgramCache();
+}
+
+int ProgramCache::request(const char* vertexSource, const char* fragmentSource) {
+    return start({ Stage{ GL_VERTEX_SHADER, vertexSource, 0 }, Stage{ GL_FRAGMENT_SHADER, fragmentSource, 0 } });
+}
+
+int ProgramCache::requestCompute(const char* computeSource) {
+    return start({ Stage{ GL_COMPUTE_SHADER, computeSource, 0 } });
+}
+
+int ProgramCache::start(std::vector<Stage> stages) {
+    uint64_t key = hashString(driver);
+    for (const Stage& stage : stages) {
+        key = hashString(std::to_string(stage.type) + "\n" + stage.source, key);
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].key == key) {
+            return static_cast<int>(i);
+        }
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.stages = std::move(stages);
+    entry.program.id = glCreateProgram();
+    entry.fromBinary = binaries && loadBinary(entry);
+    if (!entry.fromBinary) {
+        compile(entry);
+    }
+    entries.push_back(std::move(entry));
+    return static_cast<int>(entries.size()) - 1;
+}
+
+// Compile and link without asking for any status, so nothing waits here
+void ProgramCache::compile(Entry& entry) {
+    for (Stage& stage : entry.stages) {
+        stage.shader = glCreateShader(stage.type);
+        const char* source = stage.source.c_str();
+        glShaderSource(stage.shader, 1, &source, nullptr);
+        glCompileShader(stage.shader);
+        glAttachShader(entry.program.id, stage.shader);
+    }
+    if (binaries) {
+        glProgramParameteri(entry.program.id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(entry.program.id);
+}
+
+const ShaderProgram& ProgramCache::program(int handle) {
+    Entry& entry = entries[handle];
+    if (entry.finished) {
+        return entry.program;
+    }
+    entry.finished = true;
+
+    int success = GL_FALSE;
+    glGetProgramiv(entry.program.id, GL_LINK_STATUS, &success);
+    if (!success && entry.fromBinary) {
+        // A driver update the version string did not reveal; build it again
+        glDeleteProgram(entry.program.id);
+        entry.program.id = glCreateProgram();
+        entry.fromBinary = false;
+        compile(entry);
+        glGetProgramiv(entry.program.id, GL_LINK_STATUS, &success);
+    }
+
+    for (Stage& stage : entry.stages) {
+        if (!stage.shader) continue;
+        int compiled = GL_FALSE;
+        glGetShaderiv(stage.shader, GL_COMPILE_STATUS, &compiled);
+        if (!compiled) {
+            char infoLog[512];
+            glGetShaderInfoLog(stage.shader, 512, nullptr, infoLog);
+            std::cerr << "Shader error:\n" << infoLog << std::endl;
+        }
+        glDetachShader(entry.program.id, stage.shader);
+        glDeleteShader(stage.shader);
+        stage.shader = 0;
+    }
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(entry.program.id, 512, nullptr, infoLog);
+        std::cerr << "Program linking error:\n" << infoLog << std::endl;
+    }
+    else if (binaries && !entry.fromBinary) {
+        storeBinary(entry);
+    }
+
+    reflectProgram(entry.program);
+    return entry.program;
+}
+
+std::string ProgramCache::binaryPath(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(directory) / name).string();
+}
+
+bool ProgramCache::loadBinary(Entry& entry) {
+    std::ifstream in(binaryPath(entry.key), std::ios::binary);
+    BinaryHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != kBinaryMagic ||
+        header.version != kBinaryVersion || header.key != entry.key) {
+        return false;
+    }
+    std::vector<char> data(header.size);
+    if (!in.read(data.data(), data.size())) {
+        return false;
+    }
+    // Like glLinkProgram, this may finish on a driver thread; program() checks it
+    glProgramBinary(entry.program.id, header.format, data.data(), static_cast<GLsizei>(data.size()));
+    return true;
+}
+
+void ProgramCache::storeBinary(const Entry& entry) {
+    int size = 0;
+    glGetProgramiv(entry.program.id, GL_PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0) {
+        return;
+    }
+    std::vector<char> data(size);
+    GLenum format = 0;
+    glGetProgramBinary(entry.program.id, size, &size, &format, data.data());
+    BinaryHeader header = { kBinaryMagic, kBinaryVersion, entry.key, format, static_cast<uint32_t>(size) };
+
+    // Written to a temporary name first so a crash never leaves a torn binary
+    std::string path = binaryPath(entry.key);
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(data.data(), size);
+        if (!out) {
+            std::remove(tempPath.c_str());
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::remove(tempPath.c_str());
+    }
+}
+
+std::string ProgramCache::report() const {
+    size_t cached = 0;
+    for (const Entry& entry : entries) {
+        if (entry.fromBinary) cached++;
+    }
+    return std::to_string(entries.size()) + " programs: " + std::to_string(cached) + " from the binary cache, " +
+        std::to_string(entries.size() - cached) + " compiled" + (parallel ? " in parallel" : "");
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "shader_program.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Every program the viewer links. Requests only start the work, so with
+// KHR/ARB_parallel_shader_compile the driver compiles them side by side, and
+// the blocking status checks wait until a program is first used. Linked
+// binaries (glGetProgramBinary) are kept in `directory`, keyed by a hash of
+// the sources and the GL vendor, renderer and version, so a warm start with
+// the same driver skips compilation.
+class ProgramCache {
+public:
+    // An empty directory keeps binaries off disk
+    void create(const std::string& directory);
+    void destroy();
+
+    // Start compiling, or loading the cached binary, and return a handle; the
+    // same sources always return the same handle
+    int request(const char* vertexSource, const char* fragmentSource);
+    int requestCompute(const char* computeSource);
+
+    // Waits for the program if needed, prints compile and link errors, reflects
+    // it and stores its binary. The cache keeps ownership of the GL object.
+    const ShaderProgram& program(int handle);
+
+    // "3 programs: 2 from the binary cache, 1 compiled in parallel"
+    std::string report() const;
+
+private:
+    struct Stage {
+        unsigned int type;
+        std::string source;
+        unsigned int shader;
+    };
+    struct Entry {
+        uint64_t key = 0;
+        std::vector<Stage> stages;
+        ShaderProgram program;
+        bool fromBinary = false;
+        bool finished = false;
+    };
+
+    int start(std::vector<Stage> stages);
+    void compile(Entry& entry);
+    bool loadBinary(Entry& entry);
+    void storeBinary(const Entry& entry);
+    std::string binaryPath(uint64_t key) const;
+
+    std::vector<Entry> entries;
+    std::string directory;
+    std::string driver;  // vendor, renderer and version, part of every key
+    bool binaries = false;
+    bool parallel = false;
+};
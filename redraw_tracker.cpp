@@ -0,0 +1,13 @@
+#include "redraw_tracker.h"
+
+bool RedrawTracker::needsRedraw(const SceneState& state) const {
+    return dirty || state.width != last.width || state.height != last.height ||
+        state.view != last.view || state.projection != last.projection || state.model != last.model ||
+        state.lightDir != last.lightDir || state.lightColor != last.lightColor;
+}
+
+void RedrawTracker::drawn(const SceneState& state) {
+    last = state;
+    dirty = false;
+    frames++;
+}
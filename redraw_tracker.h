@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// What a frame's image depends on, apart from the meshes themselves
+struct SceneState {
+    glm::mat4 view = glm::mat4(0.0f);
+    glm::mat4 projection = glm::mat4(0.0f);
+    glm::mat4 model = glm::mat4(0.0f);
+    glm::vec3 lightDir = glm::vec3(0.0f);
+    glm::vec3 lightColor = glm::vec3(0.0f);
+    int width = 0;
+    int height = 0;
+};
+
+// Decides whether the on-demand loop has anything new to draw. The last
+// drawn state is kept and compared with the current one; events the state
+// cannot see (a level streamed in, the window exposed) mark it dirty.
+class RedrawTracker {
+public:
+    bool needsRedraw(const SceneState& state) const;
+    void markDirty() { dirty = true; }
+    // The frame for `state` was drawn and swapped
+    void drawn(const SceneState& state);
+    // A loop pass spent waiting for events instead of drawing
+    void waited() { waits++; }
+
+    // Frames drawn and waits since the start, for the console report
+    unsigned long long drawnFrames() const { return frames; }
+    unsigned long long idleWaits() const { return waits; }
+
+private:
+    SceneState last;
+    bool dirty = true;
+    unsigned long long frames = 0;
+    unsigned long long waits = 0;
+};
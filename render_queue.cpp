@@ -0,0 +1,17 @@
+#include "render_queue.h"
+
+#include <algorithm>
+
+uint64_t makeSortKey(unsigned int program, unsigned int material, float depth, float farPlane) {
+    // Quantized to 32 bits over [0, far]; anything behind the camera sorts first
+    float normalized = std::min(std::max(depth / farPlane, 0.0f), 1.0f);
+    uint64_t depthBits = static_cast<uint64_t>(static_cast<double>(normalized) * 4294967295.0);
+    return (static_cast<uint64_t>(program & 0xFFFFu) << 48) | (static_cast<uint64_t>(material & 0xFFFFu) << 32) | depthBits;
+}
+
+void RenderQueue::sort() {
+    // The draw index breaks ties, which is a stable sort without the extra memory
+    std::sort(queue.begin(), queue.end(), [](const Item& a, const Item& b) {
+        return a.key != b.key ? a.key < b.key : a.draw < b.draw;
+    });
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Draws sorted by a 64-bit key so that consecutive draws share as much state as
+// possible. From the top bit down the key holds the GL program (16 bits), the
+// material (16 bits) and the view depth (32 bits), so draws group by program,
+// then by material, and run front to back within a group for early depth
+// rejection.
+uint64_t makeSortKey(unsigned int program, unsigned int material, float depth, float farPlane);
+
+inline unsigned int sortKeyProgram(uint64_t key) { return static_cast<unsigned int>(key >> 48); }
+
+class RenderQueue {
+public:
+    struct Item {
+        uint64_t key;
+        unsigned int draw;  // the caller's index of the draw
+    };
+
+    void clear() { queue.clear(); }
+    void push(uint64_t key, unsigned int draw) { queue.push_back(Item{ key, draw }); }
+    // Equal keys keep the order they were pushed in
+    void sort();
+
+    const std::vector<Item>& items() const { return queue; }
+
+private:
+    std::vector<Item> queue;
+};
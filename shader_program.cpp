@@ -0,0 +1,124 @@
+#include "shader_program.h"
+
+#include <glad/glad.h>
+#include <iostream>
+#include <vector>
+
+unsigned int compileShader(unsigned int type, const char* source) {
+    unsigned int id = glCreateShader(type);
+    glShaderSource(id, 1, &source, nullptr);
+    glCompileShader(id);
+
+    int success;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetShaderInfoLog(id, 512, nullptr, infoLog);
+        std::cerr << "Shader error:\n" << infoLog << std::endl;
+    }
+    return id;
+}
+
+unsigned int createShaderProgram(const char* vertexSource, const char* fragmentSource) {
+    unsigned int program = glCreateProgram();
+    unsigned int vs = compileShader(GL_VERTEX_SHADER, vertexSource);
+    unsigned int fs = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(program, 512, nullptr, infoLog);
+        std::cerr << "Program linking error:\n" << infoLog << std::endl;
+    }
+
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    return program;
+}
+
+static unsigned int createComputeProgram(const char* computeSource) {
+    unsigned int program = glCreateProgram();
+    unsigned int cs = compileShader(GL_COMPUTE_SHADER, computeSource);
+
+    glAttachShader(program, cs);
+    glLinkProgram(program);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(program, 512, nullptr, infoLog);
+        std::cerr << "Program linking error:\n" << infoLog << std::endl;
+    }
+
+    glDeleteShader(cs);
+
+    return program;
+}
+
+int ShaderProgram::location(const char* name) const {
+    auto it = uniformLocations.find(name);
+    return it != uniformLocations.end() ? it->second : -1;
+}
+
+void reflectProgram(ShaderProgram& program) {
+    int count = 0, maxLength = 0;
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> name(static_cast<size_t>(maxLength) + 1);
+    for (int i = 0; i < count; i++) {
+        int size = 0, length = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program.id, i, static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+        // Block members have no location and are reached through their block
+        int location = glGetUniformLocation(program.id, name.data());
+        if (location < 0) continue;
+        std::string uniform(name.data(), length);
+        // Arrays are reported as "name[0]"; register the bare name as well
+        if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0) {
+            program.uniformLocations[uniform.substr(0, uniform.size() - 3)] = location;
+        }
+        program.uniformLocations[uniform] = location;
+    }
+
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+    name.assign(static_cast<size_t>(maxLength) + 1, '\0');
+    for (int i = 0; i < count; i++) {
+        int length = 0;
+        glGetActiveUniformBlockName(program.id, i, static_cast<GLsizei>(name.size()), &length, name.data());
+        program.uniformBlocks[std::string(name.data(), length)] = static_cast<unsigned int>(i);
+    }
+}
+
+ShaderProgram linkShaderProgram(const char* vertexSource, const char* fragmentSource) {
+    ShaderProgram program;
+    program.id = createShaderProgram(vertexSource, fragmentSource);
+    reflectProgram(program);
+    return program;
+}
+
+ShaderProgram linkComputeProgram(const char* computeSource) {
+    ShaderProgram program;
+    program.id = createComputeProgram(computeSource);
+    reflectProgram(program);
+    return program;
+}
+
+void bindUniformBlock(const ShaderProgram& program, const char* blockName, unsigned int binding) {
+    auto it = program.uniformBlocks.find(blockName);
+    if (it != program.uniformBlocks.end()) {
+        glUniformBlockBinding(program.id, it->second, binding);
+    }
+}
+
+void destroyShaderProgram(ShaderProgram& program) {
+    glDeleteProgram(program.id);
+    program = ShaderProgram();
+}
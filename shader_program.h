@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+unsigned int compileShader(unsigned int type, const char* source);
+unsigned int createShaderProgram(const char* vertexSource, const char* fragmentSource);
+
+// A linked program with its active uniforms and uniform blocks reflected once at
+// link time. Look locations up while setting up, never inside the frame loop.
+struct ShaderProgram {
+    unsigned int id = 0;
+    std::unordered_map<std::string, int> uniformLocations;
+    std::unordered_map<std::string, unsigned int> uniformBlocks;
+
+    // -1 when the uniform is not active in the program, like glGetUniformLocation
+    int location(const char* name) const;
+};
+
+// Fills the uniform and block tables of an already linked program
+void reflectProgram(ShaderProgram& program);
+
+ShaderProgram linkShaderProgram(const char* vertexSource, const char* fragmentSource);
+// Compute programs need a 4.3 context
+ShaderProgram linkComputeProgram(const char* computeSource);
+
+// Assigns a uniform block to a binding point; does nothing if the block is unused
+void bindUniformBlock(const ShaderProgram& program, const char* blockName, unsigned int binding);
+
+void destroyShaderProgram(ShaderProgram& program);
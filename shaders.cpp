@@ -0,0 +1,625 @@
+#include "shaders.h"
+#include "mesh.h"
+
+#include <iostream>
+#include <string>
+
+// Uniform blocks shared by all stages; layouts match FrameUniforms/ObjectUniforms
+static const char* uniformBlocks = R"glsl(
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 lightDir;
+    vec4 lightColor;
+    vec4 cameraPos;
+    vec4 frustumPlanes[6];
+    vec4 lodSelection;
+};
+
+layout (std140) uniform ObjectData {
+    mat4 mvp;
+    mat4 model;
+    mat4 normalMatrix;
+    vec4 objectColor;
+    vec4 positionOffset;
+    vec4 positionScale;
+};
+)glsl";
+
+// Vertex attribute decoding for the packed layouts (identity for float vertices)
+static const char* vertexDecode = R"glsl(
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+// offset.w is set when normals are octahedral-encoded
+vec3 decodePosition(vec4 offset, vec4 scale) {
+    return offset.xyz + aPos * scale.xyz;
+}
+
+vec3 decodeNormal(vec4 offset) {
+    return offset.w != 0.0 ? octDecode(aNormal.xy) : aNormal;
+}
+)glsl";
+
+// Fragment stages only; MaterialUniforms mirrors one entry
+static const std::string materialBlock = "const int kMaxMaterials = " + std::to_string(kMaxMaterials) + ";\n" + R"glsl(
+struct Material {
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+};
+
+layout (std140) uniform MaterialData {
+    Material materials[kMaxMaterials];
+};
+)glsl";
+
+// Clustered lighting (4.3): the light list and the froxel grid parameters
+static const std::string clusterBlock = "const uint kMaxLightsPerCluster = " + std::to_string(kMaxLightsPerCluster) + "u;\n" + R"glsl(
+struct Light {
+    vec4 positionRange;
+    vec4 color;
+    vec4 spotDirection;
+};
+
+layout (std140) uniform ClusterData {
+    uvec4 clusterGrid;
+    vec4 clusterScale;
+};
+
+layout (std430, binding = 6) readonly buffer Lights { Light lights[]; };
+)glsl";
+
+// Cascaded shadows for the directional light; ShadowUniforms mirrors the block
+static const std::string shadowBlock = "const int kMaxShadowCascades = " + std::to_string(kMaxShadowCascades) + ";\n" + R"glsl(
+layout (std140) uniform ShadowData {
+    mat4 shadowMatrices[kMaxShadowCascades];
+    vec4 cascadeEnds;
+    vec4 cascadeTexelSizes;
+    vec4 shadowParams;
+};
+
+uniform sampler2DArrayShadow shadowMap;
+)glsl";
+
+static std::string withUniformBlocks(const char* body, const std::string& prelude = std::string()) {
+    return std::string("#version 330 core\n") + uniformBlocks + prelude + body;
+}
+
+// Vertex Shader (updated for lighting)
+static const std::string vertexShaderText = withUniformBlocks(R"glsl(
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 Color;
+flat out int MaterialIndex;
+invariant gl_Position;
+
+void main() {
+    vec3 position = decodePosition(positionOffset, positionScale);
+    FragPos = vec3(model * vec4(position, 1.0));
+    Normal = mat3(normalMatrix) * decodeNormal(positionOffset);
+    Color = objectColor.rgb;
+    MaterialIndex = int(positionScale.w);
+    gl_Position = mvp * vec4(position, 1.0);
+}
+)glsl", vertexDecode);
+const char* vertexShaderSource = vertexShaderText.c_str();
+
+// Instanced vertex shader: ObjectData.model is the rotation shared by the whole
+// field, the per-instance attributes place, colour and dequantize each copy
+// (instances of different meshes can share one indirect draw)
+static const std::string instancedVertexShaderText = withUniformBlocks(R"glsl(
+layout (location = 3) in mat4 aInstanceModel;
+layout (location = 7) in mat3 aInstanceNormal;
+layout (location = 10) in vec4 aInstanceColor;
+layout (location = 11) in vec4 aInstanceOffset;
+layout (location = 12) in vec4 aInstanceScale;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 Color;
+flat out int MaterialIndex;
+invariant gl_Position;
+
+void main() {
+    vec4 world = aInstanceModel * (model * vec4(decodePosition(aInstanceOffset, aInstanceScale), 1.0));
+    FragPos = world.xyz;
+    Normal = aInstanceNormal * (mat3(normalMatrix) * decodeNormal(aInstanceOffset));
+    Color = aInstanceColor.rgb;
+    MaterialIndex = int(aInstanceScale.w);
+    gl_Position = viewProjection * world;
+}
+)glsl", vertexDecode);
+const char* instancedVertexShaderSource = instancedVertexShaderText.c_str();
+
+// Fragment Shader (updated for lighting)
+// The second output feeds OutlinePass and is dropped when only one buffer is bound.
+// With CLUSTERED_LIGHTS the lights binned into the fragment's froxel add their
+// diffuse term to the directional light's; with SHADOWS the directional light
+// is attenuated by its cascaded shadow map.
+static const char* fragmentShaderBody = R"glsl(
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 FragNormal;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec3 Color;
+flat in int MaterialIndex;
+
+#ifdef CLUSTERED_LIGHTS
+layout (std430, binding = 7) readonly buffer ClusterCells { uvec2 cells[]; };
+layout (std430, binding = 8) readonly buffer LightIndices { uint lightIndexCount; uint lightIndices[]; };
+
+// Screen tile from gl_FragCoord, depth slice from the log of view depth
+uint clusterIndex() {
+    uvec2 tile = min(uvec2(gl_FragCoord.xy * clusterScale.xy), clusterGrid.xy - 1u);
+    float viewDepth = max(-(view * vec4(FragPos, 1.0)).z, 1e-4);
+    uint slice = uint(clamp(log(viewDepth) * clusterScale.z + clusterScale.w, 0.0, float(clusterGrid.z - 1u)));
+    return (slice * clusterGrid.y + tile.y) * clusterGrid.x + tile.x;
+}
+
+// Lambertian diffuse from each light in this fragment's froxel. The falloff
+// reaches zero at the light's range, which is the sphere the cull tested.
+vec3 clusteredDiffuse(vec3 norm, vec3 diffuseColor) {
+    uvec2 cell = cells[clusterIndex()];
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < cell.y; i++) {
+        Light light = lights[lightIndices[cell.x + i]];
+        vec3 toLight = light.positionRange.xyz - FragPos;
+        float distance = length(toLight);
+        vec3 direction = toLight / max(distance, 1e-4);
+        float window = clamp(1.0 - (distance * distance) / (light.positionRange.w * light.positionRange.w), 0.0, 1.0);
+        float cone = light.spotDirection.w > -1.0
+            ? smoothstep(light.spotDirection.w, light.color.w, dot(-direction, light.spotDirection.xyz)) : 1.0;
+        result += max(dot(norm, direction), 0.0) * window * window * cone * light.color.rgb * diffuseColor;
+    }
+    return result;
+}
+#endif
+
+#ifdef SHADOWS
+// The first cascade that reaches the fragment's view depth, sampled 3x3 with
+// hardware comparison. The lookup point moves a texel and a half along the
+// normal, which keeps lit surfaces from shadowing themselves.
+float shadowVisibility(vec3 norm) {
+    float viewDepth = -(view * vec4(FragPos, 1.0)).z;
+    int cascadeCount = int(shadowParams.x);
+    int cascade = 0;
+    while (cascade < cascadeCount && viewDepth > cascadeEnds[cascade]) {
+        cascade++;
+    }
+    if (cascade == cascadeCount) {
+        return 1.0;
+    }
+    vec3 position = FragPos + norm * (cascadeTexelSizes[cascade] * 1.5);
+    vec4 coord = shadowMatrices[cascade] * vec4(position, 1.0);
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            lit += texture(shadowMap, vec4(coord.xy + vec2(x, y) * texel, float(cascade), coord.z));
+        }
+    }
+    return lit / 9.0;
+}
+#endif
+
+void main() {
+    Material material = materials[MaterialIndex];
+    vec3 ambientColor = MaterialIndex == 0 ? Color : material.ambient.rgb;
+    vec3 diffuseColor = MaterialIndex == 0 ? Color : material.diffuse.rgb;
+
+    // Ambient
+    float ambientStrength = 0.1;
+    vec3 ambient = ambientStrength * lightColor.rgb * ambientColor;
+
+    // Diffuse
+    vec3 norm = normalize(Normal);
+    vec3 lightDirNorm = normalize(-lightDir.xyz);
+    float diff = max(dot(norm, lightDirNorm), 0.0);
+    float lit = 1.0;
+#ifdef SHADOWS
+    lit = shadowVisibility(norm);
+#endif
+    vec3 diffuse = lit * diff * lightColor.rgb * diffuseColor;
+#ifdef CLUSTERED_LIGHTS
+    diffuse += clusteredDiffuse(norm, diffuseColor);
+#endif
+
+    // Specular (Blinn-Phong), only on the lit side
+    vec3 viewDir = normalize(cameraPos.xyz - FragPos);
+    vec3 halfway = normalize(lightDirNorm + viewDir);
+    float spec = diff > 0.0 ? pow(max(dot(norm, halfway), 0.0), max(material.specular.w, 1.0)) : 0.0;
+    vec3 specular = lit * spec * lightColor.rgb * material.specular.rgb;
+
+    // Combine
+    vec3 result = ambient + diffuse + specular;
+    FragColor = vec4(result, 1.0);
+    FragNormal = vec4(norm * 0.5 + 0.5, 1.0);
+}
+)glsl";
+static const std::string fragmentShaderText = withUniformBlocks(fragmentShaderBody, materialBlock);
+const char* fragmentShaderSource = fragmentShaderText.c_str();
+
+// Storage buffers in the fragment stage need 4.3; the vertex stages stay 3.3
+std::string shadingFragmentShader(bool clusteredLights, bool shadows) {
+    if (!clusteredLights && !shadows) {
+        return fragmentShaderText;
+    }
+    std::string text = clusteredLights ? "#version 430 core\n#define CLUSTERED_LIGHTS\n" : "#version 330 core\n";
+    if (shadows) {
+        text += "#define SHADOWS\n";
+    }
+    text += uniformBlocks + materialBlock;
+    if (clusteredLights) text += clusterBlock;
+    if (shadows) text += shadowBlock;
+    return text + fragmentShaderBody;
+}
+
+// Depth pre-pass over the position-only stream. gl_Position is computed exactly
+// as in the shading programs above and declared invariant in all of them, so
+// the main pass sees the same depth and can test it with GL_LEQUAL.
+static const std::string depthVertexShaderText = withUniformBlocks(R"glsl(
+invariant gl_Position;
+
+void main() {
+    vec3 position = decodePosition(positionOffset, positionScale);
+    gl_Position = mvp * vec4(position, 1.0);
+}
+)glsl", vertexDecode);
+const char* depthVertexShaderSource = depthVertexShaderText.c_str();
+
+static const std::string depthInstancedVertexShaderText = withUniformBlocks(R"glsl(
+layout (location = 3) in mat4 aInstanceModel;
+layout (location = 11) in vec4 aInstanceOffset;
+layout (location = 12) in vec4 aInstanceScale;
+
+invariant gl_Position;
+
+void main() {
+    vec4 world = aInstanceModel * (model * vec4(decodePosition(aInstanceOffset, aInstanceScale), 1.0));
+    gl_Position = viewProjection * world;
+}
+)glsl", vertexDecode);
+const char* depthInstancedVertexShaderSource = depthInstancedVertexShaderText.c_str();
+
+// Colour writes are masked off during the pre-pass; only depth is written
+const char* depthFragmentShaderSource = R"glsl(
+#version 330 core
+void main() {
+}
+)glsl";
+
+// Full-screen triangle from gl_VertexID alone, for post-processing passes
+const char* fullscreenVertexShaderSource = R"glsl(
+#version 330 core
+void main() {
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)glsl";
+
+// Screen-space outlines over the colour, normal and depth of the drawn scene.
+// The Laplacian of linear depth is zero across any plane however steep it is,
+// and large where one surface passes in front of another. Normals catch
+// creases and the edge between geometry and background (alpha 0).
+const char* outlineFragmentShader = R"glsl(
+#version 330 core
+uniform sampler2D sceneColor;
+uniform sampler2D sceneNormal;
+uniform sampler2D sceneDepth;
+uniform vec2 depthRange;  // near and far plane
+
+out vec4 FragColor;
+
+const float kDepthThreshold = 0.02;  // Laplacian relative to the depth itself
+const float kCreaseCosine = 0.5;     // normals more than 60 degrees apart
+
+float linearDepth(ivec2 p) {
+    float z = texelFetch(sceneDepth, p, 0).r * 2.0 - 1.0;
+    return 2.0 * depthRange.x * depthRange.y / (depthRange.y + depthRange.x - z * (depthRange.y - depthRange.x));
+}
+
+void main() {
+    ivec2 p = ivec2(gl_FragCoord.xy);
+    ivec2 last = textureSize(sceneColor, 0) - 1;
+    const ivec2 offsets[4] = ivec2[](ivec2(1, 0), ivec2(-1, 0), ivec2(0, 1), ivec2(0, -1));
+
+    float depth = linearDepth(p);
+    vec4 normal = texelFetch(sceneNormal, p, 0);
+    float neighbourDepths = 0.0;
+    float edge = 0.0;
+    for (int i = 0; i < 4; i++) {
+        ivec2 q = clamp(p + offsets[i], ivec2(0), last);
+        neighbourDepths += linearDepth(q);
+        vec4 neighbour = texelFetch(sceneNormal, q, 0);
+        if (neighbour.a != normal.a) {
+            edge = 1.0;
+        }
+        else if (normal.a > 0.0 && dot(normal.xyz * 2.0 - 1.0, neighbour.xyz * 2.0 - 1.0) < kCreaseCosine) {
+            edge = 1.0;
+        }
+    }
+    if (normal.a > 0.0 && abs(neighbourDepths - 4.0 * depth) > kDepthThreshold * depth) {
+        edge = 1.0;
+    }
+    FragColor = vec4(texelFetch(sceneColor, p, 0).rgb * (1.0 - edge), 1.0);
+}
+)glsl";
+
+// Frustum culling and LOD selection for indirect draws, one invocation per
+// instance. There is one command per (mesh, level); a visible instance is
+// compacted into the run of its command (starting at that command's
+// baseInstance) and counted into its instanceCount, which the host resets to
+// zero beforehand. The chosen level is kept per instance for the hysteresis,
+// mirroring selectLod(). InstanceData is read as raw floats because its tightly
+// packed mat3 has no std430 equivalent.
+static const std::string cullComputeShaderText = std::string("#version 430 core\n") + uniformBlocks + R"glsl(
+layout (local_size_x = 64) in;
+
+const uint kInstanceFloats = 37u;
+const uint kCommandWords = 5u;
+const uint kMaxLods = 4u;
+
+struct CullMesh {
+    vec4 sphere;
+    vec4 lodErrors;
+    uint lodCount;
+};
+
+layout (std430, binding = 0) readonly buffer Instances { float instances[]; };
+layout (std430, binding = 1) writeonly buffer VisibleInstances { float visibleInstances[]; };
+layout (std430, binding = 2) buffer Commands { uint commands[]; };
+layout (std430, binding = 3) readonly buffer CullMeshes { CullMesh meshes[]; };
+layout (std430, binding = 4) readonly buffer InstanceMeshes { uint instanceMeshes[]; };
+layout (std430, binding = 5) buffer InstanceLods { uint instanceLods[]; };
+
+uniform uint instanceCount;
+
+uint selectLod(CullMesh mesh, float errorToPixels, uint current) {
+    float threshold = lodSelection.y;
+    if (threshold <= 0.0) {
+        return 0u;
+    }
+    uint target = 0u;
+    for (uint level = mesh.lodCount - 1u; level > 0u; level--) {
+        if (mesh.lodErrors[level] * errorToPixels <= threshold) {
+            target = level;
+            break;
+        }
+    }
+    while (target > current && mesh.lodErrors[target] * errorToPixels > threshold * lodSelection.z) {
+        target--;
+    }
+    return target;
+}
+
+void main() {
+    uint instance = gl_GlobalInvocationID.x;
+    if (instance >= instanceCount) {
+        return;
+    }
+
+    uint base = instance * kInstanceFloats;
+    mat4 instanceModel;
+    for (int column = 0; column < 4; column++) {
+        uint c = base + uint(column) * 4u;
+        instanceModel[column] = vec4(instances[c], instances[c + 1u], instances[c + 2u], instances[c + 3u]);
+    }
+
+    // Same transform as the instanced vertex shader; scale the radius by the
+    // largest axis so non-uniform instance scales stay conservative
+    uint mesh = instanceMeshes[instance];
+    CullMesh info = meshes[mesh];
+    mat4 world = instanceModel * model;
+    vec3 center = (world * vec4(info.sphere.xyz, 1.0)).xyz;
+    float scale = max(length(world[0].xyz), max(length(world[1].xyz), length(world[2].xyz)));
+    float radius = info.sphere.w * scale;
+    for (int plane = 0; plane < 6; plane++) {
+        if (dot(frustumPlanes[plane].xyz, center) + frustumPlanes[plane].w < -radius) {
+            return;
+        }
+    }
+
+    float distance = length(center - cameraPos.xyz) - radius;
+    float errorToPixels = distance > 1e-4 ? scale * lodSelection.x / distance : 1e30;
+    uint lod = selectLod(info, errorToPixels, instanceLods[instance]);
+    instanceLods[instance] = lod;
+
+    uint command = (mesh * kMaxLods + lod) * kCommandWords;
+    uint slot = atomicAdd(commands[command + 1u], 1u);
+    uint destination = (commands[command + 4u] + slot) * kInstanceFloats;
+    for (uint i = 0u; i < kInstanceFloats; i++) {
+        visibleInstances[destination + i] = instances[base + i];
+    }
+}
+)glsl";
+const char* cullComputeShaderSource = cullComputeShaderText.c_str();
+
+// Meshlet culling for indirect draws: one workgroup per instance, its threads
+// striding over the mesh's meshlets. A meshlet survives when its sphere is
+// inside the frustum and its normal cone does not face entirely away from the
+// camera; each survivor appends one single-instance draw of its index range.
+// The cone test widens the cone's half-angle by the angle the meshlet's sphere
+// subtends, so it holds for every point of the meshlet.
+static const std::string meshletCullComputeShaderText = std::string("#version 430 core\n") + uniformBlocks + R"glsl(
+layout (local_size_x = 64) in;
+
+const uint kInstanceFloats = 37u;
+
+struct Meshlet {
+    vec4 sphere;
+    vec4 cone;
+    uint firstIndex;
+    uint indexCount;
+    uint vertexCount;
+    uint padding;
+};
+
+struct MeshletMesh {
+    vec4 sphere;
+    uint firstMeshlet;
+    uint meshletCount;
+    int baseVertex;
+    uint firstIndex;
+};
+
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer Instances { float instances[]; };
+layout (std430, binding = 1) buffer DrawCount { uint drawCount; };
+layout (std430, binding = 2) writeonly buffer Commands { DrawCommand commands[]; };
+layout (std430, binding = 3) readonly buffer MeshletMeshes { MeshletMesh meshes[]; };
+layout (std430, binding = 4) readonly buffer InstanceMeshes { uint instanceMeshes[]; };
+layout (std430, binding = 5) readonly buffer Meshlets { Meshlet meshlets[]; };
+
+uniform uint instanceCount;
+
+bool outsideFrustum(vec3 center, float radius) {
+    for (int plane = 0; plane < 6; plane++) {
+        if (dot(frustumPlanes[plane].xyz, center) + frustumPlanes[plane].w < -radius) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void main() {
+    uint instance = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    if (instance >= instanceCount) {
+        return;
+    }
+
+    uint base = instance * kInstanceFloats;
+    mat4 instanceModel;
+    for (int column = 0; column < 4; column++) {
+        uint c = base + uint(column) * 4u;
+        instanceModel[column] = vec4(instances[c], instances[c + 1u], instances[c + 2u], instances[c + 3u]);
+    }
+    mat3 instanceNormal;
+    for (int column = 0; column < 3; column++) {
+        uint c = base + 16u + uint(column) * 3u;
+        instanceNormal[column] = vec3(instances[c], instances[c + 1u], instances[c + 2u]);
+    }
+
+    // Same transforms as the instanced vertex shader
+    mat4 world = instanceModel * model;
+    mat3 normalWorld = instanceNormal * mat3(normalMatrix);
+    float scale = max(length(world[0].xyz), max(length(world[1].xyz), length(world[2].xyz)));
+
+    // The whole object first, so off-screen instances cost one test per thread
+    MeshletMesh mesh = meshes[instanceMeshes[instance]];
+    if (outsideFrustum((world * vec4(mesh.sphere.xyz, 1.0)).xyz, mesh.sphere.w * scale)) {
+        return;
+    }
+
+    for (uint m = gl_LocalInvocationID.x; m < mesh.meshletCount; m += gl_WorkGroupSize.x) {
+        Meshlet meshlet = meshlets[mesh.firstMeshlet + m];
+        vec3 center = (world * vec4(meshlet.sphere.xyz, 1.0)).xyz;
+        float radius = meshlet.sphere.w * scale;
+        if (outsideFrustum(center, radius)) {
+            continue;
+        }
+
+        if (meshlet.cone.w <= 1.0) {
+            vec3 axis = normalize(normalWorld * meshlet.cone.xyz);
+            vec3 toCenter = center - cameraPos.xyz;
+            float distance = length(toCenter);
+            if (distance > radius) {
+                float sinCone = meshlet.cone.w;
+                float cosCone = sqrt(1.0 - sinCone * sinCone);
+                float sinSphere = radius / distance;
+                float cosSphere = sqrt(1.0 - sinSphere * sinSphere);
+                // Back-facing when angle(view, axis) + cone + sphere < 90 degrees
+                bool narrow = cosCone * cosSphere - sinCone * sinSphere > 0.0;
+                if (narrow && dot(toCenter, axis) > distance * (sinCone * cosSphere + cosCone * sinSphere)) {
+                    continue;
+                }
+            }
+        }
+
+        uint slot = atomicAdd(drawCount, 1u);
+        commands[slot] = DrawCommand(meshlet.indexCount, 1u, mesh.firstIndex + meshlet.firstIndex, mesh.baseVertex, instance);
+    }
+}
+)glsl";
+const char* meshletCullComputeShaderSource = meshletCullComputeShaderText.c_str();
+
+// Light binning for clustered shading: one thread per froxel. The group pulls
+// the lights into view space a batch at a time through shared memory, each
+// thread keeps those whose sphere touches its froxel's box, then reserves a
+// contiguous run of the index list with one atomic and writes (offset, count).
+static const std::string clusterCullComputeShaderText = std::string("#version 430 core\n") + uniformBlocks + clusterBlock + R"glsl(
+layout (local_size_x = 64) in;
+
+layout (std430, binding = 7) writeonly buffer ClusterCells { uvec2 cells[]; };
+layout (std430, binding = 8) buffer LightIndices { uint lightIndexCount; uint lightIndices[]; };
+layout (std430, binding = 9) readonly buffer ClusterBounds { vec4 bounds[]; };
+
+shared vec4 batch[64];
+
+void main() {
+    uint cluster = gl_GlobalInvocationID.x;
+    bool inGrid = cluster < clusterGrid.x * clusterGrid.y * clusterGrid.z;
+    vec3 boundsMin = inGrid ? bounds[cluster * 2u].xyz : vec3(0.0);
+    vec3 boundsMax = inGrid ? bounds[cluster * 2u + 1u].xyz : vec3(0.0);
+
+    uint visible[kMaxLightsPerCluster];
+    uint count = 0u;
+    // Every thread runs every batch, in the grid or not, so the barriers are uniform
+    for (uint first = 0u; first < clusterGrid.w; first += gl_WorkGroupSize.x) {
+        uint index = first + gl_LocalInvocationIndex;
+        if (index < clusterGrid.w) {
+            vec4 light = lights[index].positionRange;
+            batch[gl_LocalInvocationIndex] = vec4((view * vec4(light.xyz, 1.0)).xyz, light.w);
+        }
+        memoryBarrierShared();
+        barrier();
+
+        uint batchSize = min(gl_WorkGroupSize.x, clusterGrid.w - first);
+        for (uint i = 0u; inGrid && i < batchSize && count < kMaxLightsPerCluster; i++) {
+            vec4 sphere = batch[i];
+            vec3 offset = clamp(sphere.xyz, boundsMin, boundsMax) - sphere.xyz;
+            if (dot(offset, offset) <= sphere.w * sphere.w) {
+                visible[count++] = first + i;
+            }
+        }
+        barrier();
+    }
+    if (!inGrid) {
+        return;
+    }
+
+    uint offset = atomicAdd(lightIndexCount, count);
+    for (uint i = 0u; i < count; i++) {
+        lightIndices[offset + i] = visible[i];
+    }
+    cells[cluster] = uvec2(offset, count);
+}
+)glsl";
+const char* clusterCullComputeShaderSource = clusterCullComputeShaderText.c_str();
+
+unsigned int addMaterial(std::vector<MaterialUniforms>& materials, const Material& material) {
+    if (materials.size() >= kMaxMaterials) {
+        std::cerr << "More than " << kMaxMaterials - 1 << " materials, drawing " << material.name << " with the default" << std::endl;
+        return 0;
+    }
+    materials.push_back(MaterialUniforms{ glm::vec4(material.ambient, 1.0f), glm::vec4(material.diffuse, 1.0f),
+                                          glm::vec4(material.specular, material.shininess) });
+    return static_cast<unsigned int>(materials.size()) - 1;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+struct Material;
+
+// Embedded GLSL sources for the viewer's programs
+extern const char* vertexShaderSource;
+extern const char* instancedVertexShaderSource;
+extern const char* fragmentShaderSource;
+extern const char* depthVertexShaderSource;
+extern const char* depthInstancedVertexShaderSource;
+extern const char* depthFragmentShaderSource;
+extern const char* fullscreenVertexShaderSource;
+extern const char* outlineFragmentShader;
+extern const char* cullComputeShaderSource;
+extern const char* meshletCullComputeShaderSource;
+extern const char* clusterCullComputeShaderSource;
+
+// Uniform buffer binding points shared by every program
+const unsigned int kFrameDataBinding = 0;
+const unsigned int kObjectDataBinding = 1;
+const unsigned int kMaterialDataBinding = 2;
+const unsigned int kClusterDataBinding = 3;
+const unsigned int kShadowDataBinding = 4;
+
+// Size of the MaterialData block. Index 0 is the default material, which
+// takes the object or instance colour, so OBJs without an MTL look as before.
+const unsigned int kMaxMaterials = 256;
+
+// Froxel grid of the clustered lighting: screen tiles by exponential depth
+// slices. Lights past kMaxLightsPerCluster in one froxel are dropped.
+const unsigned int kClusterGridX = 16;
+const unsigned int kClusterGridY = 9;
+const unsigned int kClusterGridZ = 24;
+const unsigned int kMaxLightsPerCluster = 128;
+
+// Most cascades ShadowCascades splits the view into, and the texture unit the
+// shading programs read their depth array from
+const unsigned int kMaxShadowCascades = 4;
+const unsigned int kShadowTextureUnit = 3;
+
+// std140 mirror of the FrameData block: camera and light, written once per frame
+struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 lightDir;
+    glm::vec4 lightColor;
+    glm::vec4 cameraPos;
+    glm::vec4 frustumPlanes[6];
+    // x: lodPixelScale, y: LOD error threshold in pixels (0 = full detail), z: kLodHysteresis
+    glm::vec4 lodSelection;
+};
+
+// std140 mirror of the ObjectData block, one per draw. normalMatrix is stored as a
+// mat4 to sidestep std140 mat3 padding; only its upper 3x3 is used.
+// positionOffset.w is 1 when the mesh stores octahedral normals; positionScale.w
+// is the object's index into MaterialData (InstanceData uses the same terms).
+struct ObjectUniforms {
+    glm::mat4 mvp;
+    glm::mat4 model;
+    glm::mat4 normalMatrix;
+    glm::vec4 objectColor;
+    glm::vec4 positionOffset;
+    glm::vec4 positionScale;
+};
+
+// std140 mirror of one MaterialData entry; specular.w is the Phong exponent
+struct MaterialUniforms {
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+};
+
+// Appends the MaterialData entry for an MTL material, or falls back to the
+// default material once the block is full
+unsigned int addMaterial(std::vector<MaterialUniforms>& materials, const Material& material);
+
+// std140 mirror of the ClusterData block. grid.w is the light count; scale.xy
+// turns gl_FragCoord into a tile, and slice = log(view depth) * scale.z + scale.w.
+struct ClusterUniforms {
+    glm::uvec4 grid;
+    glm::vec4 scale;
+};
+
+// std140 mirror of the ShadowData block. matrices take world space to the
+// cascade's texture coordinates and depth, cascadeEnds is the view depth where
+// each cascade stops and texelSizes the world size of one of its texels;
+// params.x is the cascade count.
+struct ShadowUniforms {
+    glm::mat4 matrices[kMaxShadowCascades];
+    glm::vec4 cascadeEnds;
+    glm::vec4 texelSizes;
+    glm::vec4 params;
+};
+
+// The shading fragment shader with optional features: clustered point and spot
+// lights (a #version 430 variant) and cascaded shadows for the directional light
+std::string shadingFragmentShader(bool clusteredLights, bool shadows);
@@ -0,0 +1,175 @@
+#include "shadow_cascades.h"
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// Blend of logarithmic and uniform split distances; all-logarithmic spends
+// too much of the first cascade right in front of the near plane
+static const float kSplitBlend = 0.75f;
+
+void ShadowCascades::create(unsigned int cascadeCount, unsigned int resolution) {
+    count = std::min(std::max(cascadeCount, 1u), kMaxShadowCascades);
+    size = resolution;
+
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, size, size, count, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+    // Hardware depth comparison with bilinear filtering of the results
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Shadow framebuffer " << size << "x" << size << " is incomplete (0x" << std::hex << status << std::dec << ")" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenBuffers(1, &uniformBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(ShadowUniforms), nullptr, GL_DYNAMIC_DRAW);
+}
+
+void ShadowCascades::destroy() {
+    glDeleteTextures(1, &depthTexture);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteBuffers(1, &uniformBuffer);
+    *this = ShadowCascades();
+}
+
+// Rounded up to a multiple of 2^(1/4), so zooming only changes a cascade's
+// size once it has grown or shrunk by about a fifth
+static float quantizeRadius(float radius) {
+    return std::exp2(std::ceil(std::log2(radius) * 4.0f) / 4.0f);
+}
+
+void ShadowCascades::update(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& eye, const glm::vec3& lightDir,
+                            const glm::vec4& sceneSphere, const glm::mat4& sceneModel) {
+    // Nothing past the far side of the scene needs a shadow
+    float nearDepth = projection[3][2] / (projection[2][2] - 1.0f);
+    float farDepth = projection[3][2] / (projection[2][2] + 1.0f);
+    float shadowDepth = glm::clamp(glm::length(glm::vec3(sceneSphere) - eye) + sceneSphere.w, nearDepth * 2.0f, farDepth);
+
+    // The light's rotation alone; every cascade shares it, so texel snapping in
+    // this space keeps the shadow edges from crawling
+    glm::vec3 direction = glm::normalize(lightDir);
+    glm::vec3 up = std::fabs(direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), direction, up);
+    glm::mat4 inverseView = glm::inverse(view);
+    glm::vec3 sceneCenter = glm::vec3(lightView * glm::vec4(glm::vec3(sceneSphere), 1.0f));
+
+    // Maps clip space [-1, 1] to texture space [0, 1] for the lookup
+    const glm::mat4 toTexture(glm::vec4(0.5f, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, 0.5f, 0.0f, 0.0f),
+                              glm::vec4(0.0f, 0.0f, 0.5f, 0.0f), glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
+    ShadowUniforms next = uniforms;
+    float sliceNear = nearDepth;
+    for (unsigned int c = 0; c < count; c++) {
+        float t = static_cast<float>(c + 1) / count;
+        float logSplit = nearDepth * std::pow(shadowDepth / nearDepth, t);
+        float uniformSplit = nearDepth + (shadowDepth - nearDepth) * t;
+        float sliceFar = kSplitBlend * logSplit + (1.0f - kSplitBlend) * uniformSplit;
+
+        // The slice's corners sit symmetrically around the view axis, so the
+        // sphere through them only depends on the two depths
+        float tanX = 1.0f / projection[0][0], tanY = 1.0f / projection[1][1];
+        float centerDepth = (sliceNear + sliceFar) * 0.5f;
+        float radius = 0.0f;
+        for (float depth : { sliceNear, sliceFar }) {
+            glm::vec3 corner(tanX * depth, tanY * depth, depth - centerDepth);
+            radius = std::max(radius, glm::length(corner));
+        }
+        radius = quantizeRadius(radius);
+
+        glm::vec3 worldCenter = glm::vec3(inverseView * glm::vec4(0.0f, 0.0f, -centerDepth, 1.0f));
+        glm::vec3 center = glm::vec3(lightView * glm::vec4(worldCenter, 1.0f));
+        float texel = 2.0f * radius / size;
+        center.x = std::floor(center.x / texel) * texel;
+        center.y = std::floor(center.y / texel) * texel;
+
+        // The light looks down -z; the depth range covers the cascade and every
+        // caster in the scene sphere between it and the light, widened to
+        // half-radius steps so it does not move with every camera step either
+        float step = radius * 0.5f;
+        float zFar = std::floor(std::min(center.z - radius, sceneCenter.z - sceneSphere.w) / step) * step;
+        float zNear = std::ceil(std::max(center.z + radius, sceneCenter.z + sceneSphere.w) / step) * step;
+        glm::mat4 lightProjection = glm::ortho(center.x - radius, center.x + radius, center.y - radius, center.y + radius, -zNear, -zFar);
+
+        Cascade& cascade = cascades[c];
+        glm::mat4 viewProjection = lightProjection * lightView;
+        cascade.stale = contentChanged || viewProjection != cascade.viewProjection || sceneModel != cascade.sceneModel;
+        cascade.viewProjection = viewProjection;
+        cascade.sceneModel = sceneModel;
+        if (cascade.stale) rendered++; else cached++;
+
+        next.matrices[c] = toTexture * viewProjection;
+        next.cascadeEnds[c] = sliceFar;
+        next.texelSizes[c] = texel;
+        sliceNear = sliceFar;
+    }
+    contentChanged = false;
+    next.params = glm::vec4(static_cast<float>(count), 0.0f, 0.0f, 0.0f);
+    if (std::memcmp(&next, &uniforms, sizeof(next)) != 0) {
+        uniforms = next;
+        glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(uniforms), &uniforms);
+    }
+}
+
+bool ShadowCascades::anyStale() const {
+    for (unsigned int c = 0; c < count; c++) {
+        if (cascades[c].stale) return true;
+    }
+    return false;
+}
+
+void ShadowCascades::beginCascade(unsigned int cascade) {
+    if (!rendering) {
+        rendering = true;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &savedFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, savedViewport);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, size, size);
+        // Slope-scaled offset against acne on surfaces at grazing angles to the
+        // light. Both sides cast, whether or not the camera pass culls back faces.
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(2.0f, 4.0f);
+        savedCullFace = glIsEnabled(GL_CULL_FACE) == GL_TRUE;
+        glDisable(GL_CULL_FACE);
+    }
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, cascade);
+    const float farDepth = 1.0f;
+    glClearBufferfv(GL_DEPTH, 0, &farDepth);
+}
+
+void ShadowCascades::endCascades() {
+    if (!rendering) {
+        return;
+    }
+    rendering = false;
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    if (savedCullFace) {
+        glEnable(GL_CULL_FACE);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, savedFramebuffer);
+    glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+}
+
+void ShadowCascades::bind() const {
+    glActiveTexture(GL_TEXTURE0 + kShadowTextureUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, kShadowDataBinding, uniformBuffer);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "shaders.h"
+
+#include <glm/glm.hpp>
+
+// Cascaded shadow maps for the directional light. The camera frustum, out to
+// where the scene ends, is split into `cascadeCount` slices, and each slice
+// gets an orthographic light view over its bounding sphere in one layer of a
+// depth texture array. The sphere is the same however the camera turns, its
+// radius is rounded up to quarter octaves and its centre snapped to whole
+// texels, so small camera moves often leave a cascade's matrix unchanged.
+// A cascade is only drawn again when its matrix, the scene's shared model
+// matrix or the meshes changed; otherwise last frame's layer is kept.
+class ShadowCascades {
+public:
+    void create(unsigned int cascadeCount, unsigned int resolution);
+    void destroy();
+
+    // Refits the cascades to this frame's camera. `sceneSphere` (xyz centre,
+    // w radius) bounds every caster; casters outside a cascade's square still
+    // land in its depth range.
+    void update(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& eye, const glm::vec3& lightDir,
+                const glm::vec4& sceneSphere, const glm::mat4& sceneModel);
+    // The meshes changed (e.g. a level streamed in); every cascade is redrawn
+    void invalidate() { contentChanged = true; }
+
+    bool stale(unsigned int cascade) const { return cascades[cascade].stale; }
+    bool anyStale() const;
+    unsigned int cascadeCount() const { return count; }
+    const glm::mat4& lightViewProjection(unsigned int cascade) const { return cascades[cascade].viewProjection; }
+
+    // Binds layer `cascade` as the depth target and clears it. The previous
+    // framebuffer and viewport are restored by endCascades().
+    void beginCascade(unsigned int cascade);
+    void endCascades();
+
+    // Binds the depth array to kShadowTextureUnit and ShadowData for shading
+    void bind() const;
+
+    // Cascades drawn and kept since create(), for the console report
+    unsigned long long renderedCascades() const { return rendered; }
+    unsigned long long cachedCascades() const { return cached; }
+
+private:
+    struct Cascade {
+        glm::mat4 viewProjection = glm::mat4(0.0f);
+        glm::mat4 sceneModel = glm::mat4(0.0f);
+        bool stale = true;
+    };
+
+    Cascade cascades[kMaxShadowCascades];
+    ShadowUniforms uniforms = {};
+    unsigned int count = 0;
+    unsigned int size = 0;
+    unsigned int depthTexture = 0;
+    unsigned int fbo = 0;
+    unsigned int uniformBuffer = 0;
+    bool contentChanged = true;
+    bool rendering = false;
+    int savedFramebuffer = 0;
+    int savedViewport[4] = {};
+    bool savedCullFace = false;
+    unsigned long long rendered = 0;
+    unsigned long long cached = 0;
+};
@@ -0,0 +1,82 @@
+#include "simulation.h"
+
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+
+static const float kRotationSpeed = 2.0f;  // radians per second
+static const float kZoomSpeed = 10.0f;     // units per second
+// A stall longer than this many steps is dropped instead of caught up
+static const int kMaxCatchUpSteps = 8;
+
+void stepCamera(CameraState& state, unsigned int keys, float dt) {
+    if (keys & kKeyRotateLeft) state.angleY += kRotationSpeed * dt;
+    if (keys & kKeyRotateRight) state.angleY -= kRotationSpeed * dt;
+    if (keys & kKeyTiltUp) state.angleZ += kRotationSpeed * dt;
+    if (keys & kKeyTiltDown) state.angleZ -= kRotationSpeed * dt;
+    if (keys & kKeyZoomIn) state.cameraDistance -= kZoomSpeed * dt;
+    if (keys & kKeyZoomOut) state.cameraDistance += kZoomSpeed * dt;
+    state.cameraDistance = glm::clamp(state.cameraDistance, 1.5f, 40.0f);
+    state.step++;
+}
+
+void buildCameraMatrices(CameraState& state, float aspect) {
+    // Original direction (3,3,3) normalized
+    state.eye = glm::normalize(glm::vec3(1.0f)) * state.cameraDistance;
+    state.projection = glm::perspective(glm::radians(45.0f), aspect, kNearPlane, kFarPlane);
+    state.view = glm::lookAt(state.eye, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    state.model = glm::mat4(1.0f);
+    state.model = glm::rotate(state.model, state.angleY, glm::vec3(0.0f, 1.0f, 0.0f)); // Y-axis
+    state.model = glm::rotate(state.model, state.angleZ, glm::vec3(0.0f, 0.0f, 1.0f)); // Z-axis
+}
+
+void UpdateThread::start(const CameraState& initial, float aspect, unsigned int stepsPerSecond) {
+    stop();
+    aspectRatio = aspect;
+    stepSeconds = 1.0 / stepsPerSecond;
+    working = initial;
+    buildCameraMatrices(working, aspectRatio);
+    states[0] = states[1] = working;
+    front = 0;
+    running = true;
+    thread = std::thread(&UpdateThread::run, this);
+}
+
+void UpdateThread::stop() {
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+CameraState UpdateThread::latest() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return states[front];
+}
+
+void UpdateThread::run() {
+    // glfwGetTime may be called from any thread
+    double next = glfwGetTime() + stepSeconds;
+    while (running) {
+        double now = glfwGetTime();
+        int steps = 0;
+        while (now >= next && steps < kMaxCatchUpSteps) {
+            stepCamera(working, input.load(std::memory_order_relaxed), static_cast<float>(stepSeconds));
+            next += stepSeconds;
+            steps++;
+        }
+        if (now >= next) {
+            next = now + stepSeconds;
+        }
+        if (steps > 0) {
+            buildCameraMatrices(working, aspectRatio);
+            std::lock_guard<std::mutex> lock(mutex);
+            states[1 - front] = working;
+            front = 1 - front;
+        }
+        double wait = next - glfwGetTime();
+        if (wait > 0.0) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Clip planes of the camera projection
+const float kNearPlane = 0.1f;
+const float kFarPlane = 100.0f;
+
+// Camera keys held down, as a bit set sampled on the main thread (GLFW only
+// reports input there) and read by the update thread
+enum InputKeys : unsigned int {
+    kKeyRotateLeft = 1u << 0,   // A
+    kKeyRotateRight = 1u << 1,  // D
+    kKeyTiltUp = 1u << 2,       // W
+    kKeyTiltDown = 1u << 3,     // S
+    kKeyZoomIn = 1u << 4,       // Q
+    kKeyZoomOut = 1u << 5,      // E
+};
+
+// Everything the render loop needs from the simulation for one frame
+struct CameraState {
+    float angleY = 0.0f;
+    float angleZ = 0.0f;
+    float cameraDistance = 5.196f;  // sqrt(3^2+3^2+3^2), the original (3,3,3) eye
+    glm::vec3 eye = glm::vec3(3.0f);
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::mat4 model = glm::mat4(1.0f);
+    unsigned long long step = 0;  // fixed steps taken so far
+};
+
+// Integrates the held keys over one step of `dt` seconds
+void stepCamera(CameraState& state, unsigned int keys, float dt);
+// Rebuilds eye, view, projection and model from the angles and distance
+void buildCameraMatrices(CameraState& state, float aspect);
+
+// Runs stepCamera at a fixed rate on its own thread, independent of how long
+// frames take or how long glfwSwapBuffers blocks. Each batch of steps is
+// published into the back half of a double buffer and flipped to the front,
+// so latest() always returns a complete state.
+class UpdateThread {
+public:
+    UpdateThread() = default;
+    ~UpdateThread() { stop(); }
+    UpdateThread(const UpdateThread&) = delete;
+    UpdateThread& operator=(const UpdateThread&) = delete;
+
+    void start(const CameraState& initial, float aspect, unsigned int stepsPerSecond);
+    void stop();
+
+    void setInput(unsigned int keys) { input.store(keys, std::memory_order_relaxed); }
+    CameraState latest() const;
+
+private:
+    void run();
+
+    std::thread thread;
+    std::atomic<bool> running{ false };
+    std::atomic<unsigned int> input{ 0 };
+    float aspectRatio = 1.0f;
+    double stepSeconds = 1.0 / 120.0;
+    CameraState working;
+    mutable std::mutex mutex;
+    CameraState states[2];
+    int front = 0;
+};
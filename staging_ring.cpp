@@ -0,0 +1,75 @@
+#include "staging_ring.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstring>
+
+// Copies out of the ring are issued at 16-byte offsets so any element type
+// lands aligned
+static const size_t kStagingAlignment = 16;
+
+void StagingRing::create(size_t bytesPerFrame, unsigned int framesInFlight) {
+    regionSize = (bytesPerFrame + kStagingAlignment - 1) / kStagingAlignment * kStagingAlignment;
+    frames = framesInFlight;
+    frame = 0;
+    head = 0;
+    fences.assign(frames, nullptr);
+    if (!GLAD_GL_VERSION_4_4) {
+        return;
+    }
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    size_t totalSize = regionSize * frames;
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_COPY_READ_BUFFER, totalSize, nullptr, flags);
+    mapped = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, totalSize, flags));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+void StagingRing::destroy() {
+    for (void* fence : fences) {
+        if (fence) glDeleteSync(static_cast<GLsync>(fence));
+    }
+    fences.clear();
+    if (mapped) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        mapped = nullptr;
+    }
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+}
+
+void StagingRing::beginFrame() {
+    head = 0;
+    GLsync fence = static_cast<GLsync>(fences[frame]);
+    if (fence) {
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(fence);
+        fences[frame] = nullptr;
+    }
+}
+
+void StagingRing::copy(unsigned int destination, size_t offset, const void* data, size_t size) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, destination);
+    if (mapped) {
+        size_t source = static_cast<size_t>(frame) * regionSize + head;
+        std::memcpy(mapped + source, data, size);
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, source, offset, size);
+    }
+    else {
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+    }
+    head = std::min(regionSize, (head + size + kStagingAlignment - 1) / kStagingAlignment * kStagingAlignment);
+}
+
+void StagingRing::endFrame() {
+    if (mapped && head > 0) {
+        fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    frame = (frame + 1) % frames;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Copy source for streaming uploads, split into `framesInFlight` regions like
+// UniformRing. Each frame stages at most one region's worth of data, which is
+// also the per-frame upload budget. On 4.4+ the ring is persistently mapped, the
+// data reaches its destination with glCopyBufferSubData, and each region is fenced
+// so it is only rewritten once the GPU has consumed it. Older contexts spend the
+// same budget on plain glBufferSubData calls.
+class StagingRing {
+public:
+    void create(size_t bytesPerFrame, unsigned int framesInFlight = 3);
+    void destroy();
+
+    // Waits until the GPU has finished with the region about to be reused
+    void beginFrame();
+    // Bytes this frame can still stage
+    size_t available() const { return regionSize - head; }
+    // Stages `size` bytes (at most available()) and copies them to `offset` of buffer `destination`
+    void copy(unsigned int destination, size_t offset, const void* data, size_t size);
+    // Fences this frame's copies
+    void endFrame();
+
+    size_t budget() const { return regionSize; }
+
+private:
+    unsigned int buffer = 0;
+    size_t regionSize = 0;
+    unsigned int frames = 0;
+    unsigned int frame = 0;
+    size_t head = 0;
+    unsigned char* mapped = nullptr;
+    std::vector<void*> fences;
+};
@@ -0,0 +1,67 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    workers.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    allDone.wait(lock, [this] { return tasks.empty() && busy == 0; });
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    size_t ranges = std::max<size_t>(std::min(workers.size(), count / std::max<size_t>(grain, 1)), 1);
+    size_t step = (count + ranges - 1) / ranges;
+    for (size_t begin = step; begin < count; begin += step) {
+        size_t end = std::min(begin + step, count);
+        submit([&body, begin, end] { body(begin, end); });
+    }
+    body(0, std::min(step, count));
+    wait();
+}
+
+void ThreadPool::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        taskReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) {
+            return;
+        }
+        std::function<void()> task = std::move(tasks.front());
+        tasks.pop_front();
+        busy++;
+        lock.unlock();
+        task();
+        lock.lock();
+        busy--;
+        if (tasks.empty() && busy == 0) allDone.notify_all();
+    }
+}
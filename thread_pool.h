@@ -0,0 +1,40 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads draining one FIFO of tasks. Tasks must not throw;
+// the destructor finishes the queued ones before joining.
+class ThreadPool {
+public:
+    // 0 starts one thread per core
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+    // Blocks until every submitted task has finished
+    void wait();
+    // Splits [0, count) into at most one range per worker, each of at least
+    // `grain` items, and runs `body(begin, end)` on them. The calling thread
+    // takes the first range, then waits as wait() does.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+    size_t threadCount() const { return workers.size(); }
+
+private:
+    void run();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskReady;
+    std::condition_variable allDone;
+    size_t busy = 0;
+    bool stopping = false;
+};
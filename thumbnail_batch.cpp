@@ -0,0 +1,251 @@
+#include "thumbnail_batch.h"
+#include "asset_loader.h"
+#include "frame_readback.h"
+#include "mesh_registry.h"
+#include "program_cache.h"
+#include "shaders.h"
+#include "uniform_ring.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Vertical field of view of every thumbnail, and how much room is left
+// around the mesh's bounding sphere
+static const float kThumbnailFov = glm::radians(30.0f);
+static const float kThumbnailMargin = 1.1f;
+
+// The parts of one OBJ in the registry, and the sphere around all of them
+struct ThumbnailSource {
+    const std::string* path = nullptr;
+    std::vector<int> meshes;
+    std::vector<unsigned int> materials;
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+};
+
+// Union of the parts' boxes, with a radius that reaches every part's sphere
+static void fitSphere(const MeshRegistry& registry, ThumbnailSource& source) {
+    glm::vec3 low = registry.mesh(source.meshes[0]).bounds.min;
+    glm::vec3 high = registry.mesh(source.meshes[0]).bounds.max;
+    for (int id : source.meshes) {
+        low = glm::min(low, registry.mesh(id).bounds.min);
+        high = glm::max(high, registry.mesh(id).bounds.max);
+    }
+    source.center = (low + high) * 0.5f;
+    source.radius = 0.0f;
+    for (int id : source.meshes) {
+        const Bounds& bounds = registry.mesh(id).bounds;
+        source.radius = std::max(source.radius, glm::length(bounds.center - source.center) + bounds.radius);
+    }
+    source.radius = std::max(source.radius, 1e-3f);
+}
+
+int runThumbnailBatch(const Options& options) {
+    auto start = std::chrono::steady_clock::now();
+
+    ProgramCache programs;
+    programs.create(options.useCache ? options.shaderCache : std::string());
+    const std::string shadingSource = shadingFragmentShader(false, false);
+    const int shadingProgram = programs.request(vertexShaderSource, shadingSource.c_str());
+
+    AssetLoader loader;
+    loader.start(options.meshPaths, options);
+    loader.wait();
+    std::cout << loader.takeReport() << std::flush;
+
+    // Everything is uploaded before the first page; a file without triangles
+    // gets no tiles
+    MeshRegistry registry;
+    registry.create(options.layout);
+    std::vector<MaterialUniforms> materials(1, MaterialUniforms{ glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) });
+    std::vector<ThumbnailSource> sources;
+    size_t maxParts = 1;
+    for (size_t i = 0; i < loader.requested(); i++) {
+        const LoadedMesh& loaded = loader.mesh(i);
+        ThumbnailSource source;
+        source.path = &options.meshPaths[i];
+        for (const std::unique_ptr<LoadedPart>& part : loaded.parts) {
+            int id = part->view.indexCount ? registry.add(part->view) : -1;
+            if (id < 0) continue;
+            source.meshes.push_back(id);
+            source.materials.push_back(part->material ? addMaterial(materials, *part->material) : 0);
+        }
+        if (source.meshes.empty()) {
+            std::cerr << loaded.path << " has no triangles, no thumbnails for it" << std::endl;
+            continue;
+        }
+        fitSphere(registry, source);
+        maxParts = std::max(maxParts, source.meshes.size());
+        sources.push_back(std::move(source));
+    }
+    loader.clear();
+    if (sources.empty()) {
+        registry.destroy();
+        programs.destroy();
+        return 1;
+    }
+
+    ShaderProgram shader = programs.program(shadingProgram);
+    bindUniformBlock(shader, "FrameData", kFrameDataBinding);
+    bindUniformBlock(shader, "ObjectData", kObjectDataBinding);
+    bindUniformBlock(shader, "MaterialData", kMaterialDataBinding);
+
+    unsigned int materialBuffer;
+    glGenBuffers(1, &materialBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, materialBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, kMaxMaterials * sizeof(MaterialUniforms), nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, materials.size() * sizeof(MaterialUniforms), materials.data());
+    glBindBufferBase(GL_UNIFORM_BUFFER, kMaterialDataBinding, materialBuffer);
+
+    // Whole meshes per page, so a mesh's angles are never split. Every page has
+    // the size of the fullest one, which keeps the readback ring allocated once.
+    const unsigned int tileSize = options.thumbnailSize;
+    const unsigned int perSide = options.atlasSize / tileSize;
+    const size_t angleCount = options.thumbnailAngles.size();
+    const size_t sourcesPerPage = perSide * perSide / angleCount;
+    const size_t pageCount = (sources.size() + sourcesPerPage - 1) / sourcesPerPage;
+    const size_t fullestPage = std::min(sourcesPerPage, sources.size()) * angleCount;
+    const int pageWidth = static_cast<int>(std::min<size_t>(perSide, fullestPage) * tileSize);
+    const int pageHeight = static_cast<int>((fullestPage + perSide - 1) / perSide * tileSize);
+
+    // The index is known before anything renders: one line per tile, with the
+    // tile's top-left corner in image coordinates
+    std::ofstream index(options.thumbnailOut + ".txt");
+    if (!index) {
+        std::cerr << "Cannot open " << options.thumbnailOut << ".txt for the thumbnail index" << std::endl;
+        glDeleteBuffers(1, &materialBuffer);
+        registry.destroy();
+        programs.destroy();
+        return 1;
+    }
+    index << "# page x y size angle mesh\n";
+    for (size_t s = 0; s < sources.size(); s++) {
+        for (size_t a = 0; a < angleCount; a++) {
+            size_t tile = s % sourcesPerPage * angleCount + a;
+            index << s / sourcesPerPage << " " << tile % perSide * tileSize << " " << tile / perSide * tileSize << " "
+                  << tileSize << " " << options.thumbnailAngles[a] << " " << *sources[s].path << "\n";
+        }
+    }
+    index.close();
+
+    // Pages are encoded on the readback's sink thread while the next one
+    // renders. None may be dropped, so a sink that falls a whole ring behind
+    // holds up the GPU side instead.
+    std::atomic<unsigned int> writeErrors{ 0 };
+    const std::string prefix = options.thumbnailOut;
+    FrameReadback readback;
+    readback.create(options.readbackFrames, [&writeErrors, prefix](const ReadbackFrame& frame) {
+        std::string path = prefix + "_" + std::to_string(frame.index) + ".ppm";
+        std::ofstream file(path, std::ios::binary);
+        if (file) {
+            writePpmFrame(file, frame);
+        }
+        if (!file) {
+            std::cerr << "Cannot write " << path << std::endl;
+            writeErrors++;
+        }
+    }, false);
+
+    // A FrameData per mesh and an ObjectData per part and angle, 512 bytes each
+    // on a GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT of up to 256. A page that does not
+    // fit on a larger alignment is pushed again into the grown ring.
+    UniformRing uniformRing;
+    uniformRing.create(fullestPage * (maxParts + 1) * 512);
+    glEnable(GL_DEPTH_TEST);
+
+    const glm::vec3 lightDir(-0.2f, -1.0f, -0.3f);
+    const glm::vec3 objectColor(1.0f, 0.0f, 0.0f);
+    // The viewer's starting view direction, from (3, 3, 3); each angle turns the mesh about Y instead
+    const glm::vec3 viewDirection = glm::normalize(glm::vec3(1.0f));
+    const float fitDistance = kThumbnailMargin / std::sin(kThumbnailFov * 0.5f);
+
+    std::vector<size_t> frameOffsets;
+    std::vector<size_t> objectOffsets;
+    for (size_t page = 0; page < pageCount; page++) {
+        size_t first = page * sourcesPerPage;
+        size_t last = std::min(first + sourcesPerPage, sources.size());
+
+        // Uniforms for every tile go in first, so the ring flushes once per page
+        do {
+            uniformRing.beginFrame();
+            frameOffsets.clear();
+            objectOffsets.clear();
+            for (size_t s = first; s < last; s++) {
+                const ThumbnailSource& source = sources[s];
+                float distance = source.radius * fitDistance;
+                glm::vec3 eye = source.center + viewDirection * distance;
+                FrameUniforms frame = {};
+                frame.view = glm::lookAt(eye, source.center, glm::vec3(0.0f, 1.0f, 0.0f));
+                frame.projection = glm::perspective(kThumbnailFov, 1.0f, std::max(distance - source.radius * kThumbnailMargin, distance * 0.01f),
+                                                    distance + source.radius * kThumbnailMargin);
+                frame.viewProjection = frame.projection * frame.view;
+                frame.lightDir = glm::vec4(lightDir, 0.0f);
+                frame.lightColor = glm::vec4(1.0f);
+                frame.cameraPos = glm::vec4(eye, 1.0f);
+                frameOffsets.push_back(uniformRing.push(&frame, sizeof(frame)));
+                for (float angle : options.thumbnailAngles) {
+                    glm::mat4 model = glm::translate(glm::mat4(1.0f), source.center) *
+                        glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f)) *
+                        glm::translate(glm::mat4(1.0f), -source.center);
+                    for (size_t p = 0; p < source.meshes.size(); p++) {
+                        const MeshRange& range = registry.mesh(source.meshes[p]);
+                        ObjectUniforms object;
+                        object.mvp = frame.viewProjection * model;
+                        object.model = model;
+                        object.normalMatrix = glm::mat4(glm::mat3(model));
+                        object.objectColor = glm::vec4(objectColor, 1.0f);
+                        object.positionOffset = glm::vec4(range.positionOffset, options.layout != VertexLayout::Float ? 1.0f : 0.0f);
+                        object.positionScale = glm::vec4(range.positionScale, static_cast<float>(source.materials[p]));
+                        objectOffsets.push_back(uniformRing.push(&object, sizeof(object)));
+                    }
+                }
+            }
+        } while (uniformRing.overflowed());
+        uniformRing.flush();
+
+        readback.bindTarget(pageWidth, pageHeight);
+        glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glUseProgram(shader.id);
+        registry.bind();
+        size_t object = 0;
+        for (size_t s = first; s < last; s++) {
+            const ThumbnailSource& source = sources[s];
+            uniformRing.bindRange(kFrameDataBinding, frameOffsets[s - first], sizeof(FrameUniforms));
+            for (size_t a = 0; a < angleCount; a++) {
+                // Tiles run left to right, top to bottom; GL counts rows from the bottom
+                size_t tile = (s - first) * angleCount + a;
+                glViewport(static_cast<int>(tile % perSide * tileSize), pageHeight - static_cast<int>((tile / perSide + 1) * tileSize),
+                           static_cast<int>(tileSize), static_cast<int>(tileSize));
+                for (int id : source.meshes) {
+                    uniformRing.bindRange(kObjectDataBinding, objectOffsets[object++], sizeof(ObjectUniforms));
+                    registry.draw(id);
+                }
+            }
+        }
+        uniformRing.endFrame();
+        readback.capture(readback.framebuffer(), pageWidth, pageHeight);
+    }
+    readback.destroy();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t thumbnails = sources.size() * angleCount;
+    std::cout << "Thumbnails: " << thumbnails << " on " << pageCount << " pages of " << pageWidth << "x" << pageHeight
+              << " in " << seconds << " s (" << thumbnails / seconds << " per second), index in " << options.thumbnailOut
+              << ".txt" << std::endl;
+
+    uniformRing.destroy();
+    glDeleteBuffers(1, &materialBuffer);
+    registry.destroy();
+    programs.destroy();
+    return writeErrors.load() || readback.deliveredFrames() != pageCount ? 1 : 0;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "options.h"
+
+// --thumbnails: renders every mesh from every --thumbnail-angles angle into
+// square tiles of atlas pages, many thumbnails per frame, with one context for
+// the whole batch. The meshes load through AssetLoader; each page is one
+// offscreen frame whose tiles are drawn with their own viewport and camera,
+// then read back through FrameReadback, whose sink thread writes it as
+// `<prefix>_<page>.ppm` while the next page renders. A mesh's angles always
+// share a page. `<prefix>.txt` indexes every tile. Needs a current GL context;
+// returns the process exit code.
+int runThumbnailBatch(const Options& options);
@@ -0,0 +1,24 @@
+#include "transform.h"
+
+glm::mat3 computeNormalMatrix(const glm::mat4& model, bool rotationAndUniformScale) {
+    glm::mat3 upper(model);
+    if (rotationAndUniformScale) {
+        return upper;
+    }
+    return glm::transpose(glm::inverse(upper));
+}
+
+void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]) {
+    // Gribb/Hartmann: each plane is the fourth row plus or minus one of the
+    // others. glm is column-major, so row r is (m[0][r], m[1][r], m[2][r], m[3][r]).
+    glm::mat4 rows = glm::transpose(viewProjection);
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[3] + rows[2];
+    planes[5] = rows[3] - rows[2];
+    for (int i = 0; i < 6; i++) {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Matrix that carries normals through `model`: the inverse-transpose of its upper
+// 3x3. When the caller knows the model is only rotation and uniform scale (as
+// the viewer's angleY/angleZ rotations are), that is the upper 3x3 itself up to
+// a scale factor, which the fragment shader's normalize() cancels, so the
+// inverse is skipped.
+glm::mat3 computeNormalMatrix(const glm::mat4& model, bool rotationAndUniformScale);
+
+// The six clip planes of `viewProjection` (left, right, bottom, top, near, far)
+// in world space, normalized so dot(plane.xyz, p) + plane.w is a signed
+// distance. A sphere is outside when that distance is below -radius for any plane.
+void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
@@ -0,0 +1,108 @@
+#include "uniform_ring.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+void UniformRing::create(size_t bytesPerFrame, unsigned int framesInFlight) {
+    int offsetAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+    alignment = static_cast<size_t>(offsetAlignment);
+    regionSize = (bytesPerFrame + alignment - 1) / alignment * alignment;
+    frames = framesInFlight;
+    frame = 0;
+    head = 0;
+    flushed = 0;
+    demand = 0;
+    fences.assign(frames, nullptr);
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    size_t totalSize = regionSize * frames;
+    if (GLAD_GL_VERSION_4_4) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, totalSize, nullptr, flags);
+        mapped = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, totalSize, flags));
+    }
+    else {
+        glBufferData(GL_UNIFORM_BUFFER, totalSize, nullptr, GL_DYNAMIC_DRAW);
+        staging.resize(regionSize);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformRing::destroy() {
+    for (void* fence : fences) {
+        if (fence) glDeleteSync(static_cast<GLsync>(fence));
+    }
+    fences.clear();
+    if (mapped) {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        mapped = nullptr;
+    }
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    staging.clear();
+}
+
+void UniformRing::beginFrame() {
+    if (demand > regionSize) {
+        // Regions cannot move while offsets into them are bound, so the whole
+        // ring is replaced between frames. GL keeps the old buffer alive for
+        // draws still in flight.
+        size_t grown = std::max(demand, regionSize * 2);
+        std::cerr << "UniformRing overflow: a frame pushed " << demand << " bytes into " << regionSize
+                  << ", growing to " << grown << " bytes per frame" << std::endl;
+        unsigned int framesInFlight = frames;
+        destroy();
+        create(grown, framesInFlight);
+        return;
+    }
+    head = 0;
+    flushed = 0;
+    demand = 0;
+    GLsync fence = static_cast<GLsync>(fences[frame]);
+    if (fence) {
+        // Normally already signalled: the region was last used `frames` frames ago
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(fence);
+        fences[frame] = nullptr;
+    }
+}
+
+size_t UniformRing::push(const void* data, size_t size) {
+    size_t aligned = (size + alignment - 1) / alignment * alignment;
+    demand += aligned;
+    size_t offset = head;
+    if (offset + size > regionSize) {
+        // Everything before `head` may already be bound for this frame's draws
+        return kFull;
+    }
+    unsigned char* region = mapped ? mapped + static_cast<size_t>(frame) * regionSize : staging.data();
+    std::memcpy(region + offset, data, size);
+    head = (offset + size + alignment - 1) / alignment * alignment;
+    return static_cast<size_t>(frame) * regionSize + offset;
+}
+
+void UniformRing::flush() {
+    if (!mapped && head > flushed) {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, static_cast<size_t>(frame) * regionSize + flushed, head - flushed, staging.data() + flushed);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    flushed = head;
+}
+
+void UniformRing::endFrame() {
+    flush();
+    fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame = (frame + 1) % frames;
+}
+
+void UniformRing::bindRange(unsigned int binding, size_t offset, size_t size) const {
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+}
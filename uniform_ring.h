@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Per-frame uniform data in one ring buffer split into `framesInFlight` regions.
+// push() is a pointer bump plus a memcpy; every allocation is aligned for
+// glBindBufferRange. On 4.4+ the buffer is persistently mapped and each region is
+// fenced; older contexts stage in CPU memory and upload once per frame.
+// A frame that pushes more than its region gets kFull back for the pushes that
+// do not fit, and the next beginFrame() reallocates every region larger.
+class UniformRing {
+public:
+    // push() result for data that did not fit; nothing was written or bound
+    static constexpr size_t kFull = ~static_cast<size_t>(0);
+
+    void create(size_t bytesPerFrame, unsigned int framesInFlight = 3);
+    void destroy();
+
+    // Waits until the GPU has finished with the region about to be reused, or
+    // grows the ring when the previous frame overflowed
+    void beginFrame();
+    // Copies `size` bytes into this frame's region and returns their buffer
+    // offset, or kFull when the region has no room left; draws that needed the
+    // data must be skipped
+    size_t push(const void* data, size_t size);
+    // Whether a push in this frame returned kFull
+    bool overflowed() const { return demand > regionSize; }
+    // Makes everything pushed so far visible to the GPU; call before drawing
+    void flush();
+    // Fences this frame's region; call after the frame's last draw
+    void endFrame();
+
+    void bindRange(unsigned int binding, size_t offset, size_t size) const;
+
+    // Returns false, binding nothing, when the data did not fit
+    template <typename T>
+    bool pushAndBind(unsigned int binding, const T& data) {
+        size_t offset = push(&data, sizeof(T));
+        if (offset == kFull) {
+            return false;
+        }
+        bindRange(binding, offset, sizeof(T));
+        return true;
+    }
+
+private:
+    unsigned int buffer = 0;
+    size_t regionSize = 0;
+    size_t alignment = 256;
+    unsigned int frames = 0;
+    unsigned int frame = 0;
+    size_t head = 0;
+    size_t flushed = 0;
+    // Bytes this frame's pushes asked for, including those that did not fit
+    size_t demand = 0;
+    unsigned char* mapped = nullptr;
+    std::vector<unsigned char> staging;
+    std::vector<void*> fences;
+};
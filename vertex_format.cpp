@@ -0,0 +1,139 @@
+#include "vertex_format.h"
+
+#include <glad/glad.h>
+#include <glm/gtc/packing.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+struct QuantizedVertex {
+    uint16_t position[4];  // w is padding so the normal stays 4-byte aligned
+    uint32_t normal;       // octahedral x/y in the low two 10-bit fields
+    uint16_t texCoord[2];
+};
+static_assert(sizeof(QuantizedVertex) == 16, "quantized vertex must stay 16 bytes");
+
+// Maps a unit vector onto the [-1, 1] square of an octahedron unfolded around +z
+static glm::vec2 octEncode(glm::vec3 n) {
+    n /= glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+    glm::vec2 e(n.x, n.y);
+    if (n.z < 0.0f) {
+        e = glm::vec2((1.0f - glm::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+                      (1.0f - glm::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+    }
+    return e;
+}
+
+static uint32_t packSnorm10(float v) {
+    int q = static_cast<int>(glm::round(glm::clamp(v, -1.0f, 1.0f) * 511.0f));
+    return static_cast<uint32_t>(q) & 0x3FFu;
+}
+
+static uint32_t packNormal(const glm::vec3& normal) {
+    if (glm::dot(normal, normal) == 0.0f) {
+        return 0;
+    }
+    glm::vec2 e = octEncode(glm::normalize(normal));
+    return packSnorm10(e.x) | (packSnorm10(e.y) << 10);
+}
+
+unsigned int vertexStride(VertexLayout layout) {
+    return layout == VertexLayout::Float ? sizeof(Vertex) : sizeof(QuantizedVertex);
+}
+
+bool parseVertexLayout(const char* name, VertexLayout& layout) {
+    if (std::strcmp(name, "float") == 0) layout = VertexLayout::Float;
+    else if (std::strcmp(name, "half") == 0) layout = VertexLayout::Half;
+    else if (std::strcmp(name, "unorm16") == 0) layout = VertexLayout::Unorm16;
+    else return false;
+    return true;
+}
+
+const char* vertexLayoutName(VertexLayout layout) {
+    switch (layout) {
+    case VertexLayout::Half: return "half";
+    case VertexLayout::Unorm16: return "unorm16";
+    default: return "float";
+    }
+}
+
+PackedVertices packVertices(const Mesh& mesh, VertexLayout layout) {
+    PackedVertices packed;
+    packed.layout = layout;
+    packed.stride = vertexStride(layout);
+    packed.data.resize(mesh.vertices.size() * packed.stride);
+
+    if (layout == VertexLayout::Float) {
+        std::memcpy(packed.data.data(), mesh.vertices.data(), packed.data.size());
+        return packed;
+    }
+
+    // Half stores positions in [-1, 1] around the centre; Unorm16 in [0, 1] from min
+    glm::vec3 extent = glm::max(mesh.bounds.max - mesh.bounds.min, glm::vec3(1e-6f));
+    if (layout == VertexLayout::Half) {
+        packed.positionOffset = (mesh.bounds.min + mesh.bounds.max) * 0.5f;
+        packed.positionScale = extent * 0.5f;
+    }
+    else {
+        packed.positionOffset = mesh.bounds.min;
+        packed.positionScale = extent;
+    }
+
+    QuantizedVertex* out = reinterpret_cast<QuantizedVertex*>(packed.data.data());
+    for (const Vertex& vertex : mesh.vertices) {
+        glm::vec3 p = (vertex.position - packed.positionOffset) / packed.positionScale;
+        for (int i = 0; i < 3; i++) {
+            out->position[i] = layout == VertexLayout::Half ? glm::packHalf1x16(p[i]) : glm::packUnorm1x16(p[i]);
+        }
+        out->position[3] = 0;
+        out->normal = packNormal(vertex.normal);
+        out->texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+        out->texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+        out++;
+    }
+    return packed;
+}
+
+void setupVertexAttributes(VertexLayout layout) {
+    if (layout == VertexLayout::Float) {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+    }
+    else {
+        GLenum positionType = layout == VertexLayout::Half ? GL_HALF_FLOAT : GL_UNSIGNED_SHORT;
+        GLboolean positionNormalized = layout == VertexLayout::Half ? GL_FALSE : GL_TRUE;
+        glVertexAttribPointer(0, 4, positionType, positionNormalized, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, position));
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, normal));
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, texCoord));
+    }
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+}
+
+unsigned int positionStride(VertexLayout layout) {
+    return layout == VertexLayout::Float ? sizeof(glm::vec3) : sizeof(QuantizedVertex::position);
+}
+
+void extractPositions(VertexLayout layout, const void* vertices, size_t count, unsigned char* positions) {
+    // Both vertex structs start with the position
+    unsigned int stride = vertexStride(layout);
+    unsigned int size = positionStride(layout);
+    const unsigned char* in = static_cast<const unsigned char*>(vertices);
+    for (size_t i = 0; i < count; i++) {
+        std::memcpy(positions + i * size, in + i * stride, size);
+    }
+}
+
+void setupPositionAttribute(VertexLayout layout) {
+    if (layout == VertexLayout::Float) {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, positionStride(layout), (void*)0);
+    }
+    else {
+        GLenum positionType = layout == VertexLayout::Half ? GL_HALF_FLOAT : GL_UNSIGNED_SHORT;
+        GLboolean positionNormalized = layout == VertexLayout::Half ? GL_FALSE : GL_TRUE;
+        glVertexAttribPointer(0, 4, positionType, positionNormalized, positionStride(layout), (void*)0);
+    }
+    glEnableVertexAttribArray(0);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <vector>
+
+// GPU vertex layouts the Mesh upload path can produce. Float is the plain
+// interleaved Vertex (32 bytes); the quantized layouts are 16 bytes per vertex
+// with octahedral normals packed as GL_INT_2_10_10_10_REV.
+enum class VertexLayout {
+    Float,   // vec3 position, vec3 normal, vec2 texCoord as 32-bit floats
+    Half,    // half-float position relative to the bounds centre, half texCoord
+    Unorm16  // 16-bit normalized position relative to the bounds, half texCoord
+};
+
+// Vertex data ready for glBufferData plus what the vertex shader needs to turn
+// the stored position back into model space: position = offset + stored * scale.
+struct PackedVertices {
+    VertexLayout layout = VertexLayout::Float;
+    unsigned int stride = 0;
+    std::vector<unsigned char> data;
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+};
+
+unsigned int vertexStride(VertexLayout layout);
+
+// Selects a layout by its command line name ("float", "half", "unorm16")
+bool parseVertexLayout(const char* name, VertexLayout& layout);
+const char* vertexLayoutName(VertexLayout layout);
+
+PackedVertices packVertices(const Mesh& mesh, VertexLayout layout);
+
+// Describes locations 0-2 for the buffer bound to GL_ARRAY_BUFFER in the current VAO
+void setupVertexAttributes(VertexLayout layout);
+
+// The position-only stream for depth passes keeps the leading position of each
+// packed vertex unchanged: 12 bytes for Float, 8 for the quantized layouts
+unsigned int positionStride(VertexLayout layout);
+void extractPositions(VertexLayout layout, const void* vertices, size_t count, unsigned char* positions);
+// Describes location 0 for a position-only buffer bound to GL_ARRAY_BUFFER
+void setupPositionAttribute(VertexLayout layout);